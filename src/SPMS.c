@@ -1,17 +1,38 @@
+#define _GNU_SOURCE // memfd_create
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <stddef.h>
 #include <time.h>
 #include <unistd.h>   
 #include <sys/wait.h> 
-
-#define MAX_USERS 5
-#define MAX_SLOTS 3 // parking slots available (can change if necessary)
-#define MAX_RESOURCES 3
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <pthread.h>
+
+#define REPORT_FILE "SPMS_Report_G34.txt"
+#define EXPORT_PREFIX "SPMS_Report_G34_" // machine-readable exports: <prefix><bookings|summary>.<ext>
+#define EXPORT_BUFFER_SIZE (1 << 20)
+#define MEMBERS_FILE "members.txt" // one member name per line, read at startup
+#define JOURNAL_FILE "SPMS_G34.wal" // booking journal and snapshot, kept in the -store directory
+#define SNAPSHOT_FILE "SPMS_G34.snap"
+#define CAPACITY_FILE "capacity.txt" // "<parking|essential|essentials> <count>" lines, read at startup
+#define DEFAULT_SLOTS 3 // parking slots when the capacity file does not set them
+#define DEFAULT_RESOURCES 3 // units of each essential when the capacity file does not set them
+#define MAX_CAPACITY 32767 // slot numbers and usage counters are shorts
 #define MAX_ESSENTIALS 6
-#define MAX_BOOKINGS 5000
+#define MAX_PARSE_THREADS 64
+#define PARSE_CHUNK_MIN_BYTES (256 * 1024) // smaller batch files are parsed on the calling thread
+#define MAX_SCHEDULE_THREADS 64
+#define SCHEDULE_PARALLEL_MIN 4096 // fewer new bookings are scheduled on the calling thread
+#define OPTI_EXACT_SLOTS 64 // slots of an oversubscribed day opti fills by weighted interval scheduling, the rest greedily
 
 // Test time defintion
 #define TEST_START_DAY 10
@@ -32,34 +53,113 @@ typedef struct Member {
     char name[MAX_STRING_LENGTH];
 } Member;
 
-Member members[MAX_USERS] = {
-    {"member_A"},
-    {"member_B"},
-    {"member_C"},
-    {"member_D"},
-    {"member_E"}
-};
-
-typedef struct Booking {
-    char member[MAX_STRING_LENGTH];
-    int parking_slot;
-    char date[11]; // YYYY-MM-DD
-    char time[6]; // hh:mm
-    float duration;
-    char essentials[3][20]; // 3 pairs
-    int essential_count;
-    int status; // 0 = pending, 1 = accepted, 2 = rejected
-    time_t start_time; //?
-    time_t end_time;
-    char type[12];
-} Booking;
+// Used when there is no members file
+static const char* default_members[] = {"member_A", "member_B", "member_C", "member_D", "member_E"};
+
+// Member registry, a booking refers to a member by its index (dense id)
+Member* members = NULL;
+int member_count = 0;
+static int member_capacity = 0;
+// Open-addressing hash table from name to id + 1 (0 marks an empty slot)
+static int* member_slots = NULL;
+static int member_slot_count = 0; // power of two
+
+// Booking types, the value doubles as the priority level
+#define TYPE_ESSENTIALS 0 // "*": essentials only, no parking slot
+#define TYPE_PARKING 1
+#define TYPE_RESERVATION 2
+#define TYPE_EVENT 3
+#define PRIORITY_LEVELS 4
+
+static const char* booking_types[] = {"*", "Parking", "Reservation", "Event"};
+
+#define MINUTES_PER_DAY (24 * 60)
+// Booking years accepted by the parser. Times are int minutes since 1970-01-01 00:00,
+// which overflow from about year 6053 on; this range keeps them and the day arithmetic well inside.
+#define MIN_YEAR 1900
+#define MAX_YEAR 2999
+
+// Bookings kept as one array per field (structure of arrays).
+// The schedulers only read the hot fields, so their scans stay cache-dense.
+// Display text is not stored: member names come from the registry, type names
+// from booking_types[] and the date/time strings are formatted from the start minute.
+// The arrays are split into fixed-size chunks, so the list grows by adding a
+// chunk without moving existing bookings and a booking index never changes.
+// The parent's chunks live in a shared memory file created before the child
+// processes are forked; each child maps the chunks it has not seen yet and
+// reads the bookings in place, so only counts and results go through the pipes.
+#define BOOKING_CHUNK_SHIFT 12
+#define BOOKING_CHUNK_SIZE (1 << BOOKING_CHUNK_SHIFT) // bookings per chunk
+#define BOOKING_CHUNK_MASK (BOOKING_CHUNK_SIZE - 1)
+
+typedef struct BookingChunk {
+    // hot fields
+    int member[BOOKING_CHUNK_SIZE];                 // index into members
+    int start[BOOKING_CHUNK_SIZE];                  // minutes since 1970-01-01 00:00
+    int end[BOOKING_CHUNK_SIZE];                    // start + duration, rounded up to a minute
+    unsigned char priority[BOOKING_CHUNK_SIZE];     // booking type / priority level (TYPE_*)
+    unsigned char essentials[BOOKING_CHUNK_SIZE];   // bitmask of requested essentials (1 << RES_*)
+    unsigned char cancelled[BOOKING_CHUNK_SIZE];    // 1 once removed by cancelBooking
+    // cold field, only read by the reports
+    float duration[BOOKING_CHUNK_SIZE];             // hours as entered
+} BookingChunk;
+
+// Scheduling state of a chunk, private to the Scheduler module
+typedef struct ScheduleChunk {
+    int accept_pos[BOOKING_CHUNK_SIZE];             // position in the day's accept list (while accepted)
+    int placed_start[BOOKING_CHUNK_SIZE];           // times the booking is indexed with; modifyBooking
+    int placed_end[BOOKING_CHUNK_SIZE];             // changes the store before the worker hears of it
+    short parking_slot[BOOKING_CHUNK_SIZE];
+    unsigned char status[BOOKING_CHUNK_SIZE];       // 0 = pending, 1 = accepted, 2 = rejected
+} ScheduleChunk;
 
 typedef struct BookingList {
-    Booking* bookings;       // array of all bookigns
-    int booking_count;       // total number of bookings
-    int capacity;            // capacity of the array
+    BookingChunk** chunks;
+    ScheduleChunk** states;     // allocated on the first scheduler run
+    int chunk_count;            // allocated chunks
+    int state_count;            // allocated scheduling states
+    int chunk_capacity;         // size of the chunk tables
+    int booking_count;          // total number of bookings
+    int shared_fd;              // shared memory file of the chunks (-1 -> private heap chunks)
 } BookingList;
 
+// Field of the booking with index i (usable as an lvalue)
+#define BOOKING_AT(list, field, i) ((list)->chunks[(i) >> BOOKING_CHUNK_SHIFT]->field[(i) & BOOKING_CHUNK_MASK])
+#define SCHEDULE_AT(list, field, i) ((list)->states[(i) >> BOOKING_CHUNK_SHIFT]->field[(i) & BOOKING_CHUNK_MASK])
+
+// Outcome of parsing a booking command
+enum {
+    PARSE_OK,
+    PARSE_NOT_BOOKING,      // not a booking command, ignored
+    PARSE_BAD_MEMBER,
+    PARSE_BAD_DATETIME,
+    PARSE_ZERO_DURATION
+};
+
+// Booking command parsed from a line. Parsing has no side effects, the
+// booking is only stored (or the error reported) by submit_booking.
+typedef struct BookingRequest {
+    int error;                  // PARSE_*
+    int member;                 // index into members
+    int start;                  // minutes since 1970-01-01 00:00
+    float duration;             // hours
+    unsigned char type;         // TYPE_*
+    unsigned char essentials;   // bitmask of requested essentials
+} BookingRequest;
+
+// Scheduling algorithms, in the order of their Scheduler workers and report sections
+enum {
+    ALGORITHM_FCFS,
+    ALGORITHM_PRIO,
+    ALGORITHM_OPTI
+};
+
+// Child processes: a Scheduler worker per algorithm, then the Output and Analyzer modules
+#define ALGORITHM_COUNT 3 // fcfs, prio, opti
+#define CHILD_OUTPUT ALGORITHM_COUNT
+#define CHILD_ANALYZER (ALGORITHM_COUNT + 1)
+#define CHILD_COUNT (ALGORITHM_COUNT + 2)
+
 // Global structure to hold scheduler results for the analyzer
 typedef struct SchedulerResults {
     int* accepted_idx;      // array of indices of accepted bookings
@@ -69,26 +169,83 @@ typedef struct SchedulerResults {
     int total_received;     // total number of bookings received
 } SchedulerResults;
 
+// Essential resources tracked by the occupancy counters (pairs are id ^ 1)
+enum {
+    RES_BATTERY, RES_CABLE,
+    RES_LOCKER, RES_UMBRELLA,
+    RES_INFLATION, RES_VALET,
+    RESOURCE_TYPES
+};
+
+// Id an unknown essential name is interned to. It has no units, so every scheduler rejects
+// the booking, which is still stored and reported like the others. Its bit is the last of
+// the essentials mask, clear of the pairs and of the parking occupancy category.
+#define RES_UNKNOWN 7
+
+// Capacities of the facility, set from the capacity file before the children are forked
 typedef struct SystemResources {
-    int parking_slots[MAX_SLOTS];  // use to check if parcking slot is occupied
-    int battery;
-    int cable;
-    int locker;
-    int umbrella;
-    int valet;
-    int inflation;
+    int parking_slots;                  // number of parking slots
+    int essentials[RESOURCE_TYPES];     // units of each essential (RES_*)
 } SystemResources;
 
 SystemResources sys_res = {
-    .parking_slots = {0},
-    .battery = MAX_RESOURCES,
-    .cable = MAX_RESOURCES,
-    .locker = MAX_RESOURCES,
-    .umbrella = MAX_RESOURCES,
-    .valet = MAX_RESOURCES,
-    .inflation = MAX_RESOURCES
+    .parking_slots = DEFAULT_SLOTS,
+    .essentials = {DEFAULT_RESOURCES, DEFAULT_RESOURCES, DEFAULT_RESOURCES,
+                   DEFAULT_RESOURCES, DEFAULT_RESOURCES, DEFAULT_RESOURCES}
 };
 
+// Minutes covered by one day of occupancy. Only bookings of the same date conflict, and they all
+// start before its midnight, so the part of a booking past midnight never decides a conflict.
+#define OCCUPANCY_MINUTES MINUTES_PER_DAY
+#define OCCUPANCY_LEAVES 2048 // power of 2 >= OCCUPANCY_MINUTES
+
+// Usage of one essential over the minutes of a day.
+// Segment tree with range-add and range-max, so a capacity check is one query.
+typedef struct ResourceOccupancy {
+    short max[2 * OCCUPANCY_LEAVES]; // max usage in the node's range
+    short add[2 * OCCUPANCY_LEAVES]; // usage added to the whole range
+} ResourceOccupancy;
+
+static int resource_capacity(int res) {
+    return (res >= 0 && res < RESOURCE_TYPES) ? sys_res.essentials[res] : 0;
+}
+
+static void occupancy_add(ResourceOccupancy* occ, int node, int lo, int hi, int start, int end, int value) {
+    if (end <= lo || hi <= start) return;
+    if (start <= lo && hi <= end) {
+        occ->max[node] += value;
+        occ->add[node] += value;
+        return;
+    }
+    int mid = (lo + hi) / 2;
+    occupancy_add(occ, 2 * node, lo, mid, start, end, value);
+    occupancy_add(occ, 2 * node + 1, mid, hi, start, end, value);
+    short left = occ->max[2 * node], right = occ->max[2 * node + 1];
+    occ->max[node] = (left > right ? left : right) + occ->add[node];
+}
+
+static int occupancy_max(const ResourceOccupancy* occ, int node, int lo, int hi, int start, int end) {
+    if (end <= lo || hi <= start) return 0;
+    if (start <= lo && hi <= end) return occ->max[node];
+    int mid = (lo + hi) / 2;
+    int left = occupancy_max(occ, 2 * node, lo, mid, start, end);
+    int right = occupancy_max(occ, 2 * node + 1, mid, hi, start, end);
+    return (left > right ? left : right) + occ->add[node];
+}
+
+// First (or with last, the final) minute of [start, end) whose usage reaches need (-1 if none)
+static int occupancy_find(const ResourceOccupancy* occ, int node, int lo, int hi, int start, int end, int need, bool last) {
+    if (end <= lo || hi <= start || occ->max[node] < need) return -1;
+    if (hi - lo == 1) return lo;
+    int mid = (lo + hi) / 2;
+    need -= occ->add[node];
+    int found = last ? occupancy_find(occ, 2 * node + 1, mid, hi, start, end, need, last)
+                     : occupancy_find(occ, 2 * node, lo, mid, start, end, need, last);
+    if (found >= 0) return found;
+    return last ? occupancy_find(occ, 2 * node, lo, mid, start, end, need, last)
+                : occupancy_find(occ, 2 * node + 1, mid, hi, start, end, need, last);
+}
+
 // Map essentials pairs
 static const char* essential_pairs[PAIR_COUNT][2] = {
     {"battery", "cable"},
@@ -96,33 +253,143 @@ static const char* essential_pairs[PAIR_COUNT][2] = {
     {"inflationservice", "valetpark"}
 };
 
-void FCFS_Scheduler(Booking* bookings, int numBookings, int* rejectList, int* rejectCounter);
-void Priority_Scheduler(Booking* bookings, int numBookings, int* rejectList, int* rejectCounter);
-void command_processor(char *cmd);
-static bool time_overlap(Booking* booking1, Booking* booking2);
-static int check_parking_conflict(Booking* item, Booking* bookings, int* acceptList, int acceptCount);
-static int check_essential_conflict(Booking* item, Booking* bookings, int* acceptList, int acceptCount);
-
-// Return priority level
-static int get_priority_level(const char *type) {
-    if (strcmp(type, "Event") == 0) return 3;
-    if (strcmp(type, "Reservation") == 0) return 2;
-    if (strcmp(type, "Parking") == 0) return 1;
-    return 0;
+// Changes of the booking store, as recorded in the journal
+enum {
+    JOURNAL_ADD,
+    JOURNAL_CANCEL,
+    JOURNAL_MODIFY
+};
+
+void command_processor(const char *cmd);
+static void journal_booking(int op, int index);
+static int check_parking_conflict(BookingList* list, int i);
+static int check_essential_conflict(BookingList* list, int i);
+
+// Initialize an empty booking list, chunks are allocated as bookings are added
+void init_booking_list(BookingList* list) {
+    list->chunks = NULL;
+    list->states = NULL;
+    list->chunk_count = 0;
+    list->state_count = 0;
+    list->chunk_capacity = 0;
+    list->booking_count = 0;
+    list->shared_fd = -1;
 }
 
-// Compare priority level of two bookings
-int comparePriority(const void* a, const void* b) {
-    Booking* bookingA = (Booking*)a;
-    Booking* bookingB = (Booking*)b;
-    return get_priority_level(bookingB->type) - get_priority_level(bookingA->type);
+// Initialize an empty booking list whose chunks can be mapped by forked processes
+void init_shared_booking_list(BookingList* list) {
+    init_booking_list(list);
+    list->shared_fd = memfd_create("spms_bookings", MFD_CLOEXEC);
+    if (list->shared_fd < 0) {
+        fprintf(stderr, "Error: Shared booking store creation failed.\n");
+        exit(1);
+    }
 }
 
-// Initialize and allocate memory to booking list
-void init_booking_list(BookingList* list, int size) {
-    list->bookings = malloc(size * sizeof(Booking));
-    list->booking_count = 0;
-    list->capacity = size;
+// Bytes of the shared file taken by one chunk (mappings start on a page boundary)
+static size_t chunk_stride(void) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return (sizeof(BookingChunk) + page - 1) / page * page;
+}
+
+void free_booking_list(BookingList* list) {
+    for (int c = 0; c < list->chunk_count; c++) {
+        if (list->shared_fd >= 0) munmap(list->chunks[c], sizeof(BookingChunk));
+        else free(list->chunks[c]);
+    }
+    for (int c = 0; c < list->state_count; c++) {
+        free(list->states[c]);
+    }
+    free(list->chunks);
+    free(list->states);
+    if (list->shared_fd >= 0) close(list->shared_fd);
+    init_booking_list(list);
+}
+
+// Grow the chunk tables to hold needed chunks (existing chunks never move)
+static void grow_chunk_tables(BookingList* list, int needed) {
+    if (needed <= list->chunk_capacity) return;
+    int new_capacity = list->chunk_capacity ? list->chunk_capacity : 8;
+    while (new_capacity < needed) new_capacity *= 2;
+    BookingChunk** chunks = realloc(list->chunks, new_capacity * sizeof(BookingChunk*));
+    if (chunks) list->chunks = chunks;
+    ScheduleChunk** states = realloc(list->states, new_capacity * sizeof(ScheduleChunk*));
+    if (states) list->states = states;
+    if (!chunks || !states) {
+        fprintf(stderr, "Failed to allocate memory.\n");
+        exit(1);
+    }
+    list->chunk_capacity = new_capacity;
+}
+
+// Map chunks of the shared file up to needed chunks
+static void map_booking_chunks(BookingList* list, int needed) {
+    while (list->chunk_count < needed) {
+        void* chunk = mmap(NULL, sizeof(BookingChunk), PROT_READ | PROT_WRITE, MAP_SHARED,
+                           list->shared_fd, (off_t)list->chunk_count * chunk_stride());
+        if (chunk == MAP_FAILED) {
+            fprintf(stderr, "Failed to allocate memory.\n");
+            exit(1);
+        }
+        list->chunks[list->chunk_count++] = chunk;
+    }
+}
+
+// Make room for count bookings
+static void reserve_bookings(BookingList* list, int count) {
+    int needed = (count + BOOKING_CHUNK_SIZE - 1) >> BOOKING_CHUNK_SHIFT;
+    if (needed <= list->chunk_count) return;
+    grow_chunk_tables(list, needed);
+
+    if (list->shared_fd >= 0) {
+        // Extend the shared file, pages are only backed once written
+        if (ftruncate(list->shared_fd, (off_t)needed * chunk_stride()) < 0) {
+            fprintf(stderr, "Failed to allocate memory.\n");
+            exit(1);
+        }
+        map_booking_chunks(list, needed);
+        return;
+    }
+    while (list->chunk_count < needed) {
+        BookingChunk* chunk = malloc(sizeof(BookingChunk));
+        if (!chunk) {
+            fprintf(stderr, "Failed to allocate memory.\n");
+            exit(1);
+        }
+        list->chunks[list->chunk_count++] = chunk;
+    }
+}
+
+// Catch up with the first count bookings the parent wrote to the shared file
+static void attach_booking_list(BookingList* list, int count) {
+    int needed = (count + BOOKING_CHUNK_SIZE - 1) >> BOOKING_CHUNK_SHIFT;
+    grow_chunk_tables(list, needed);
+    map_booking_chunks(list, needed);
+    list->booking_count = count;
+}
+
+// Number of bookings stored in chunk c
+static int chunk_length(const BookingList* list, int c) {
+    int length = list->booking_count - (c << BOOKING_CHUNK_SHIFT);
+    return length < BOOKING_CHUNK_SIZE ? length : BOOKING_CHUNK_SIZE;
+}
+
+// Reset the scheduling state of the bookings from index 'from' on
+static void reset_schedule(BookingList* list, int from) {
+    while (list->state_count < list->chunk_count) {
+        ScheduleChunk* state = malloc(sizeof(ScheduleChunk));
+        if (!state) {
+            fprintf(stderr, "Failed to allocate memory.\n");
+            exit(1);
+        }
+        list->states[list->state_count++] = state;
+    }
+    for (int i = from; i < list->booking_count; i++) {
+        SCHEDULE_AT(list, status, i) = BOOKING_AT(list, cancelled, i) ? STATUS_REJECTED : STATUS_PENDING;
+        SCHEDULE_AT(list, parking_slot, i) = -1;
+        SCHEDULE_AT(list, placed_start, i) = BOOKING_AT(list, start, i);
+        SCHEDULE_AT(list, placed_end, i) = BOOKING_AT(list, end, i);
+    }
 }
 
 // Global variables for parent to hold all sent bookings
@@ -130,699 +397,3050 @@ static BookingList allBookings;
 // Global variables for each scheduler (e.g., FCFS and Priority)
 SchedulerResults fcfs_results = {NULL, 0, NULL, 0, 0};
 SchedulerResults prio_results = {NULL, 0, NULL, 0, 0};
+SchedulerResults opti_results = {NULL, 0, NULL, 0, 0};
 // Global variable to track invalid commands
 int invalid_command_count = 0;
 
-// Tool function
-static void to_lower_case(char *str) {
-    for (int i = 0; str[i]; i++) {
-        str[i] = (char)tolower((unsigned char)str[i]);
-    }
+// Days since 1970-01-01 of a civil date (proleptic Gregorian calendar)
+static int days_from_civil(int year, int month, int day) {
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yoe = year - era * 400;
+    int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+static bool is_leap_year(int year) {
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
 }
 
-static bool validate_datetime(const char *date, const char *time) {
-    if (strlen(date) != 10 || date[4] != '-' || date[7] != '-') return false;
-    if (strlen(time) != 5 || time[2] != ':') return false;
+// Read exactly n decimal digits, false on any other character
+static bool parse_digits(const char* str, int n, int* value) {
+    int v = 0;
+    for (int k = 0; k < n; k++) {
+        unsigned d = (unsigned)(str[k] - '0');
+        if (d > 9) return false;
+        v = v * 10 + (int)d;
+    }
+    *value = v;
+    return true;
+}
 
+// Validate "YYYY-MM-DD" and "hh:mm" and convert them to minutes since 1970-01-01 00:00 in one pass.
+// Pure calendar arithmetic, so the result does not depend on the host timezone or DST rules.
+// Years outside MIN_YEAR..MAX_YEAR are rejected, their minutes would not fit in an int.
+static bool parse_datetime(const char* date, int date_len, const char* time, int time_len, int* minutes) {
+    static const unsigned char month_days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
     int year, month, day, hour, minute;
-    if (sscanf(date, "%d-%d-%d", &year, &month, &day) != 3) return false;
-    if (sscanf(time, "%d:%d", &hour, &minute) != 2) return false;
 
-    return (hour >= 0 && hour <= 23 && minute >= 0 && minute <= 59);
+    if (date_len != 10 || time_len != 5) return false;
+    if (!parse_digits(date, 4, &year) || date[4] != '-' ||
+        !parse_digits(date + 5, 2, &month) || date[7] != '-' ||
+        !parse_digits(date + 8, 2, &day)) return false;
+    if (!parse_digits(time, 2, &hour) || time[2] != ':' ||
+        !parse_digits(time + 3, 2, &minute)) return false;
+
+    if (year < MIN_YEAR || year > MAX_YEAR) return false;
+    if (month < 1 || month > 12 || day < 1) return false;
+    if (day > month_days[month - 1] + (month == 2 && is_leap_year(year))) return false;
+    if (hour > 23 || minute > 59) return false;
+
+    *minutes = days_from_civil(year, month, day) * MINUTES_PER_DAY + hour * 60 + minute;
+    return true;
 }
 
-static time_t convert_to_time_t(const char* date, const char* time) {
-    struct tm tm = {0};
-    sscanf(date, "%d-%d-%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday);
-    sscanf(time, "%d:%d", &tm.tm_hour, &tm.tm_min);
-   
-    tm.tm_year -= 1900;
-    tm.tm_mon -= 1;
-   
-    return mktime(&tm);
+static void civil_from_days(int days, int* year, int* month, int* day) {
+    days += 719468;
+    int era = (days >= 0 ? days : days - 146096) / 146097;
+    int doe = days - era * 146097;
+    int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int mp = (5 * doy + 2) / 153;
+    *day = doy - (153 * mp + 2) / 5 + 1;
+    *month = mp < 10 ? mp + 3 : mp - 9;
+    *year = yoe + era * 400 + (*month <= 2);
+}
+
+// Day number of a minute timestamp (rounds down for dates before 1970)
+static int day_of(int minutes) {
+    return minutes >= 0 ? minutes / MINUTES_PER_DAY : -((-minutes + MINUTES_PER_DAY - 1) / MINUTES_PER_DAY);
+}
+
+static void format_date(int day, char* buf) {
+    int year, month, mday;
+    civil_from_days(day, &year, &month, &mday);
+    sprintf(buf, "%04d-%02d-%02d", year, month, mday);
 }
 
 // Resource management function
-static const char* get_pair_essential(const char *essential) {
-    char lower_essential[MAX_STRING_LENGTH];
-    strncpy(lower_essential, essential, sizeof(lower_essential)-1);
-    lower_essential[sizeof(lower_essential)-1] = '\0';
-    to_lower_case(lower_essential);
+// Return the resource id of an essential name of len characters (-1 if unknown, case-insensitive)
+static int get_essential_id(const char *essential, int len) {
+    for (int res = 0; res < RESOURCE_TYPES; res++) {
+        const char* name = essential_pairs[res / 2][res % 2];
+        if ((int)strlen(name) == len && strncasecmp(essential, name, len) == 0) return res;
+    }
+    return -1;
+}
+
+static const char* essential_name(int res) {
+    return res == RES_UNKNOWN ? "unknown" : essential_pairs[res / 2][res % 2];
+}
+
+// Add the pair of every essential in the mask (battery <-> cable, ...)
+static unsigned char with_pairs(unsigned char essentials) {
+    return essentials | ((essentials & 0x15) << 1) | ((essentials & 0x2A) >> 1);
+}
+
+// Read the facility capacities: "parking <n>", "<essential> <n>" or "essentials <n>" for all
+// essentials, one per line. Missing file or lines keep the defaults.
+static void load_capacities(const char* filename) {
+    FILE* file = fopen(filename, "r");
+    if (!file) return;
 
-    size_t i;
-    for (int i = 0; i < PAIR_COUNT; i++) {
-        if (strcmp(lower_essential, essential_pairs[i][0]) == 0) return essential_pairs[i][1];
-        if (strcmp(lower_essential, essential_pairs[i][1]) == 0) return essential_pairs[i][0];
+    char line[256], name[64];
+    int count;
+    while (fgets(line, sizeof(line), file)) {
+        if (sscanf(line, "%63s %d", name, &count) != 2) continue;
+        if (count < 1 || count > MAX_CAPACITY) {
+            fprintf(stderr, "Error: Invalid capacity %d for %s in %s\n", count, name, filename);
+            continue;
+        }
+        int res = get_essential_id(name, (int)strlen(name));
+        if (strcasecmp(name, "parking") == 0) {
+            sys_res.parking_slots = count;
+        } else if (strcasecmp(name, "essentials") == 0) {
+            for (int r = 0; r < RESOURCE_TYPES; r++) sys_res.essentials[r] = count;
+        } else if (res >= 0) {
+            sys_res.essentials[res] = count;
+        } else {
+            fprintf(stderr, "Error: Unknown resource %s in %s\n", name, filename);
+        }
     }
-    return NULL;
+    fclose(file);
+}
+
+/* Stage Statistics */
+// Latency of each stage of the command loop and the modules. Every process keeps its
+// own counters; the children send theirs to the parent for the stats command.
+enum {
+    STAGE_PARSE,            // parsing one booking command
+    STAGE_CREATE_BOOKING,   // storing one booking
+    STAGE_ADD_BATCH,        // a whole addBatch command
+    STAGE_IPC,              // sending or receiving one message
+    STAGE_FCFS,             // FCFS_Scheduler run
+    STAGE_PRIO,             // Priority_Scheduler run
+    STAGE_OPTI,             // Opti_Scheduler run
+    STAGE_PRINT_BOOKINGS,   // rendering one algorithm's booking lists
+    STAGE_ANALYZER,         // summary and occupancy of one algorithm
+    STAGE_PRINT_COMMAND,    // a whole printBookings command
+    STAGE_PRINT_SCHEDULING, // scheduling part of a printBookings command (slowest worker)
+    STAGE_PRINT_REPORT,     // report part of a printBookings command (slower of Output and Analyzer)
+    STAGE_PRINT_OTHER,      // rest of a printBookings command: pipes and the parent
+    STAGE_COUNT
+};
+
+static const char* stage_names[STAGE_COUNT] = {
+    "parse", "create_booking", "addBatch", "ipc transfer", "FCFS_Scheduler",
+    "Priority_Scheduler", "Opti_Scheduler", "print_bookings", "Analyzer", "printBookings",
+    "print scheduling", "print report", "print IPC/other"
+};
+
+// Log-linear latency histogram: 4 buckets per power of two, so a percentile is
+// known to within about 12%
+#define LATENCY_BUCKETS 256
+
+typedef struct StageStats {
+    long long count;
+    long long total_ns;
+    long long buckets[LATENCY_BUCKETS];
+} StageStats;
+
+static StageStats stage_stats[STAGE_COUNT];
+
+static long long monotonic_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+static int latency_bucket(long long ns) {
+    if (ns < 4) return ns > 0 ? (int)ns : 0;
+    int msb = 63 - __builtin_clzll(ns);
+    int bucket = (msb - 1) * 4 + (int)((ns >> (msb - 2)) & 3);
+    return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+}
+
+// Middle of the range of latencies counted in a bucket
+static double bucket_latency(int bucket) {
+    if (bucket < 4) return bucket;
+    int shift = bucket / 4 - 1;
+    long long low = (long long)(4 + bucket % 4) << shift;
+    return low + ((1LL << shift) - 1) / 2.0;
+}
+
+static void record_stage(StageStats* stats, long long ns) {
+    stats->count++;
+    stats->total_ns += ns;
+    stats->buckets[latency_bucket(ns)]++;
+}
+
+static void merge_stage(StageStats* into, const StageStats* from) {
+    into->count += from->count;
+    into->total_ns += from->total_ns;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) into->buckets[b] += from->buckets[b];
+}
+
+static double stage_percentile(const StageStats* stats, double fraction) {
+    long long rank = (long long)(fraction * stats->count);
+    long long seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        seen += stats->buckets[b];
+        if (seen > rank) return bucket_latency(b);
+    }
+    return 0;
 }
 
+static void print_stage_stats(const StageStats* stats) {
+    printf("Stage                    Count     Total s     Mean us      p50 us      p99 us\n");
+    for (int k = 0; k < STAGE_COUNT; k++) {
+        const StageStats* st = &stats[k];
+        double mean = st->count ? st->total_ns / (double)st->count : 0;
+        printf("%-20s %9lld %11.3f %11.2f %11.2f %11.2f\n", stage_names[k], st->count, st->total_ns / 1e9,
+               mean / 1e3, stage_percentile(st, 0.5) / 1e3, stage_percentile(st, 0.99) / 1e3);
+    }
+}
 
 /* Scheduler Module Functions */
 
-// Check if bookings involving essentials have conflict (0 -> no conflict, -1 -> has conflict)
-static int check_essential_conflict(Booking* item, Booking* bookings, int* acceptList, int acceptCount){
-    // Check essentials for conflict  
-    if (item->essential_count > 0) {
-        // 1. Validate all pairs first
-        for (int e = 0; e < item->essential_count; e++) {
-            const char* pair = get_pair_essential(item->essentials[e]);
-            if (!pair) return -1; // Invalid essential
+// Accepted booking interval held by a parking slot
+typedef struct SlotInterval {
+    int start;
+    int end;
+} SlotInterval;
+
+// Accepted intervals of one parking slot on one day, kept sorted by start.
+// A slot holds one car at a time, so the intervals never overlap.
+typedef struct SlotTimeline {
+    SlotInterval* items;
+    int count;
+    int capacity;
+} SlotTimeline;
+
+// Accepted booking in a priority timeline
+typedef struct PriorityEntry {
+    int start;
+    int end;
+    int booking;                    // booking index
+} PriorityEntry;
+
+// Accepted bookings of one priority level on one day, kept sorted by start.
+// A booking overlapping [start, end) starts at most max_length minutes before
+// start, so the preemption search is a binary search plus a short scan.
+typedef struct PriorityTimeline {
+    PriorityEntry* items;
+    int count;
+    int capacity;
+    int max_length;                 // longest booking added since the last clear
+} PriorityTimeline;
+
+// Slot availability is also kept as bitsets per hour block of the day's occupancy range:
+// bit s of a block is set while slot s holds a booking overlapping the block. A slot
+// whose bit is clear in every block of a window is free for the window, so the first
+// free slot is a find-first-set over the OR of those blocks.
+#define SLOT_BLOCK_MINUTES 60
+#define SLOT_BLOCKS (OCCUPANCY_MINUTES / SLOT_BLOCK_MINUTES)
+
+typedef unsigned long long SlotWord;
+#define SLOT_WORD_BITS 64
+
+static int slot_words = 0;          // words per block bitset, set by init_slot_index
+
+// Per-day index of the parking slots (bookings on different dates never conflict)
+typedef struct DayIndex {
+    int day;                        // days since 1970-01-01
+    SlotTimeline* slots;            // one timeline per parking slot
+    SlotWord* busy;                 // SLOT_BLOCKS bitsets of slot_words words
+    unsigned short* block_use;      // bookings of each slot overlapping each block (block-major)
+    ResourceOccupancy* essentials[RESOURCE_TYPES]; // allocated on first use
+    PriorityTimeline accepted[PRIORITY_LEVELS];    // accepted bookings by priority
+    PriorityTimeline waitlist;      // rejected bookings sorted by start, promoted when capacity frees up
+    // Bookings of the day, scheduled independently of the other days
+    int* pending;                   // booking indices in arrival order
+    int pending_count;
+    int pending_capacity;
+    int scheduled;                  // pending bookings already scheduled
+    int* accept_list;               // accepted bookings of the day by accept position
+    int* accept_keys;               // booking being scheduled when each position was added
+    int accept_count;
+    int accept_capacity;
+} DayIndex;
+
+// Open-addressing table from day number to DayIndex
+typedef struct ConflictIndex {
+    DayIndex** days;
+    int day_count;
+    int capacity;                   // always a power of 2
+} ConflictIndex;
+
+static ConflictIndex conflict_index = {NULL, 0, 0};
+
+static unsigned int hash_day(int day) {
+    unsigned int h = (unsigned int)day;
+    h ^= h >> 16;
+    h *= 0x45d9f3bu;
+    h ^= h >> 16;
+    return h;
+}
+
+static DayIndex* get_day_index(int day, bool create) {
+    ConflictIndex* ci = &conflict_index;
+
+    if (ci->capacity > 0) {
+        unsigned int mask = ci->capacity - 1;
+        for (unsigned int h = hash_day(day) & mask; ci->days[h]; h = (h + 1) & mask) {
+            if (ci->days[h]->day == day) return ci->days[h];
         }
-       
-        // 2. Check conflicts with existing bookings
-        for (int e = 0; e < item->essential_count; e++) {
-            const char* essential = item->essentials[e];
+    }
+    if (!create) return NULL;
+
+    // Grow the table when it gets half full
+    if ((ci->day_count + 1) * 2 > ci->capacity) {
+        int new_capacity = ci->capacity ? ci->capacity * 2 : 64;
+        DayIndex** new_days = calloc(new_capacity, sizeof(DayIndex*));
+        if (!new_days) {
+            fprintf(stderr, "Failed to allocate memory.\n");
+            exit(1);
+        }
+        for (int i = 0; i < ci->capacity; i++) {
+            if (!ci->days[i]) continue;
+            unsigned int h = hash_day(ci->days[i]->day) & (new_capacity - 1);
+            while (new_days[h]) h = (h + 1) & (new_capacity - 1);
+            new_days[h] = ci->days[i];
+        }
+        free(ci->days);
+        ci->days = new_days;
+        ci->capacity = new_capacity;
+    }
 
-            int total_usage = 0;
-    
-            // Count usage of the essential in accepted bookings
-            for (int i = 0; i < acceptCount; i++) {
-                Booking* acceptedBooking = &bookings[acceptList[i]];
-                if (!time_overlap(item, acceptedBooking)) continue;
-
-                for (int j = 0; j < acceptedBooking->essential_count; j++) {
-                    if (strcmp(acceptedBooking->essentials[j], essential) == 0) {
-                        total_usage++;
-                    }
-                }
-            }
+    DayIndex* di = calloc(1, sizeof(DayIndex));
+    if (di) {
+        di->slots = calloc(sys_res.parking_slots, sizeof(SlotTimeline));
+        di->busy = calloc((size_t)SLOT_BLOCKS * slot_words, sizeof(SlotWord));
+        di->block_use = calloc((size_t)SLOT_BLOCKS * sys_res.parking_slots, sizeof(unsigned short));
+    }
+    if (!di || !di->slots || !di->busy || !di->block_use) {
+        fprintf(stderr, "Failed to allocate memory.\n");
+        exit(1);
+    }
+    di->day = day;
+
+    unsigned int mask = ci->capacity - 1;
+    unsigned int h = hash_day(day) & mask;
+    while (ci->days[h]) h = (h + 1) & mask;
+    ci->days[h] = di;
+    ci->day_count++;
+    return di;
+}
 
-            // Check if total usage exceeds the limit
-            if (total_usage >= MAX_RESOURCES) {
-                return -1; // Essential conflict
-            }
+// Release everything accepted on the day (keeps its bookings and the allocated arrays)
+static void reset_day_index(DayIndex* di) {
+    for (int s = 0; s < sys_res.parking_slots; s++) {
+        di->slots[s].count = 0;
+    }
+    memset(di->busy, 0, (size_t)SLOT_BLOCKS * slot_words * sizeof(SlotWord));
+    memset(di->block_use, 0, (size_t)SLOT_BLOCKS * sys_res.parking_slots * sizeof(unsigned short));
+    for (int r = 0; r < RESOURCE_TYPES; r++) {
+        if (di->essentials[r]) memset(di->essentials[r], 0, sizeof(ResourceOccupancy));
+    }
+    for (int p = 0; p < PRIORITY_LEVELS; p++) {
+        di->accepted[p].count = 0;
+        di->accepted[p].max_length = 0;
+    }
+    di->waitlist.count = 0;
+    di->waitlist.max_length = 0;
+    di->accept_count = 0;
+}
+
+// Number of intervals starting before the given time (binary search)
+static int timeline_lower_bound(const SlotTimeline* tl, int start) {
+    int lo = 0, hi = tl->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (tl->items[mid].start < start) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Check if the slot is free for [start, end)
+static bool timeline_is_free(const SlotTimeline* tl, int start, int end) {
+    // Intervals are disjoint, so only the last one starting before end can overlap
+    int i = timeline_lower_bound(tl, end);
+    return i == 0 || tl->items[i - 1].end <= start;
+}
+
+// Check if the slot is free for [start, end) once its interval starting at skip is released
+static bool timeline_is_free_without(const SlotTimeline* tl, int start, int end, int skip) {
+    int i = timeline_lower_bound(tl, end);
+    if (i > 0 && tl->items[i - 1].start == skip) i--;
+    return i == 0 || tl->items[i - 1].end <= start;
+}
+
+static void timeline_insert(SlotTimeline* tl, int start, int end) {
+    if (tl->count == tl->capacity) {
+        int new_capacity = tl->capacity ? tl->capacity * 2 : 8;
+        SlotInterval* items = realloc(tl->items, new_capacity * sizeof(SlotInterval));
+        if (!items) {
+            fprintf(stderr, "Failed to allocate memory.\n");
+            exit(1);
         }
+        tl->items = items;
+        tl->capacity = new_capacity;
     }
 
-    return 0;
+    int pos = timeline_lower_bound(tl, start);
+    memmove(&tl->items[pos + 1], &tl->items[pos], (tl->count - pos) * sizeof(SlotInterval));
+    tl->items[pos].start = start;
+    tl->items[pos].end = end;
+    tl->count++;
 }
 
-// Check if the booking of parking has any conflict with accepted bookings
-// (0-N -> no conflict, indicate first avail parking slot, -1 -> has conflict)
-static int check_parking_conflict(Booking* item, Booking* bookings, int* acceptList, int acceptCount) {
-    // Check parking for conflict
-    int available_slots[MAX_SLOTS] = {1, 1, 1};
-
-    for (int i = 0; i < acceptCount; i++) {
-        int acceptedIndex = acceptList[i];
-        Booking* acceptedBooking = &bookings[acceptedIndex];
-
-        // Check if the accepted booking overlaps in time with the current booking
-        if (time_overlap(item, acceptedBooking)) {
-            // If there is a time overlap, mark the parking slot as unavailable
-            if (acceptedBooking->parking_slot >= 0 && acceptedBooking->parking_slot < MAX_SLOTS) {
-                available_slots[acceptedBooking->parking_slot] = 0;
-            }
+static void timeline_remove(SlotTimeline* tl, int start) {
+    int pos = timeline_lower_bound(tl, start);
+    if (pos >= tl->count || tl->items[pos].start != start) return;
+    memmove(&tl->items[pos], &tl->items[pos + 1], (tl->count - pos - 1) * sizeof(SlotInterval));
+    tl->count--;
+}
+
+// Size the slot bitsets for the configured number of parking slots
+static void init_slot_index(void) {
+    slot_words = (sys_res.parking_slots + SLOT_WORD_BITS - 1) / SLOT_WORD_BITS;
+}
+
+// Blocks of the day index overlapped by [start, end) (absolute minutes)
+static void slot_blocks(const DayIndex* di, int start, int end, int* first, int* last) {
+    int offset = di->day * MINUTES_PER_DAY;
+    *first = (start - offset) / SLOT_BLOCK_MINUTES;
+    *last = (end - 1 - offset) / SLOT_BLOCK_MINUTES;
+    if (*last >= SLOT_BLOCKS) *last = SLOT_BLOCKS - 1;
+}
+
+// Count a booking the slot now holds (+1) or released (-1) in its blocks and keep the bits in step
+static void update_slot_blocks(DayIndex* di, int slot, int start, int end, int value) {
+    int first, last;
+    slot_blocks(di, start, end, &first, &last);
+    SlotWord bit = 1ULL << (slot % SLOT_WORD_BITS);
+    for (int b = first; b <= last; b++) {
+        unsigned short* use = &di->block_use[b * sys_res.parking_slots + slot];
+        SlotWord* word = &di->busy[b * slot_words + slot / SLOT_WORD_BITS];
+        *use += value;
+        if (*use) *word |= bit;
+        else *word &= ~bit;
+    }
+}
+
+// Lowest numbered slot free for [start, end) (-1 if none)
+static int first_free_slot(const DayIndex* di, int start, int end) {
+    int first, last;
+    slot_blocks(di, start, end, &first, &last);
+    for (int w = 0; w < slot_words; w++) {
+        SlotWord touched = 0;
+        for (int b = first; b <= last; b++) touched |= di->busy[b * slot_words + w];
+
+        int slots_in_word = sys_res.parking_slots - w * SLOT_WORD_BITS;
+        SlotWord valid = slots_in_word >= SLOT_WORD_BITS ? ~0ULL : (1ULL << slots_in_word) - 1;
+        SlotWord untouched = ~touched & valid;
+        int limit = untouched ? __builtin_ctzll(untouched) : SLOT_WORD_BITS;
+
+        // A touched slot below the first untouched one may still be free inside its blocks
+        for (SlotWord rest = touched; rest; rest &= rest - 1) {
+            int bit = __builtin_ctzll(rest);
+            if (bit >= limit) break;
+            int slot = w * SLOT_WORD_BITS + bit;
+            if (timeline_is_free(&di->slots[slot], start, end)) return slot;
         }
+        if (untouched) return w * SLOT_WORD_BITS + limit;
+    }
+    return -1;
+}
+
+// Number of entries starting before the given time (binary search)
+static int priority_lower_bound(const PriorityTimeline* pt, int start) {
+    int lo = 0, hi = pt->count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (pt->items[mid].start < start) lo = mid + 1;
+        else hi = mid;
     }
+    return lo;
+}
 
-    // If the booking already has a valid parking slot, check if it is still available
-    if (item->parking_slot >= 0 && item->parking_slot < MAX_SLOTS) {
-        if (available_slots[item->parking_slot]) {
-            return item->parking_slot; // Keep the current slot if available
+static void priority_insert(PriorityTimeline* pt, int start, int end, int booking) {
+    if (pt->count == pt->capacity) {
+        int new_capacity = pt->capacity ? pt->capacity * 2 : 8;
+        PriorityEntry* items = realloc(pt->items, new_capacity * sizeof(PriorityEntry));
+        if (!items) {
+            fprintf(stderr, "Failed to allocate memory.\n");
+            exit(1);
+        }
+        pt->items = items;
+        pt->capacity = new_capacity;
+    }
+
+    // Entries starting together stay in booking order
+    int pos = priority_lower_bound(pt, start);
+    while (pos < pt->count && pt->items[pos].start == start && pt->items[pos].booking < booking) pos++;
+    memmove(&pt->items[pos + 1], &pt->items[pos], (pt->count - pos) * sizeof(PriorityEntry));
+    pt->items[pos].start = start;
+    pt->items[pos].end = end;
+    pt->items[pos].booking = booking;
+    pt->count++;
+    if (end - start > pt->max_length) pt->max_length = end - start;
+}
+
+static void priority_remove(PriorityTimeline* pt, int start, int booking) {
+    for (int pos = priority_lower_bound(pt, start); pos < pt->count && pt->items[pos].start == start; pos++) {
+        if (pt->items[pos].booking != booking) continue;
+        memmove(&pt->items[pos], &pt->items[pos + 1], (pt->count - pos - 1) * sizeof(PriorityEntry));
+        pt->count--;
+        return;
+    }
+}
+
+// Add (+1) or release (-1) the essentials of a booking in the occupancy counters.
+// Booking an essential also takes its pair, as the reports count it.
+static void update_essentials(DayIndex* di, BookingList* list, int i, int value) {
+    // Occupancy is indexed by the minute of the booking's day, up to its midnight
+    int start = SCHEDULE_AT(list, placed_start, i) - di->day * MINUTES_PER_DAY;
+    int end = SCHEDULE_AT(list, placed_end, i) - di->day * MINUTES_PER_DAY;
+    if (end > OCCUPANCY_MINUTES) end = OCCUPANCY_MINUTES;
+    unsigned char essentials = with_pairs(BOOKING_AT(list, essentials, i));
+
+    for (int res = 0; res < RESOURCE_TYPES; res++) {
+        if (!(essentials & (1 << res))) continue;
+
+        if (!di->essentials[res]) {
+            di->essentials[res] = calloc(1, sizeof(ResourceOccupancy));
+            if (!di->essentials[res]) {
+                fprintf(stderr, "Failed to allocate memory.\n");
+                exit(1);
+            }
         }
+        occupancy_add(di->essentials[res], 1, 0, OCCUPANCY_LEAVES, start, end, value);
+    }
+}
+
+// Record an accepted booking in the slot index and essential counters
+static void index_booking(BookingList* list, int i) {
+    int start = SCHEDULE_AT(list, placed_start, i), end = SCHEDULE_AT(list, placed_end, i);
+    DayIndex* di = get_day_index(day_of(start), true);
+    int slot = SCHEDULE_AT(list, parking_slot, i);
+    if (slot >= 0 && slot < sys_res.parking_slots) {
+        timeline_insert(&di->slots[slot], start, end);
+        update_slot_blocks(di, slot, start, end, 1);
+    }
+    update_essentials(di, list, i, 1);
+    priority_insert(&di->accepted[BOOKING_AT(list, priority, i)], start, end, i);
+}
+
+// Release the slot interval and essentials of an accepted booking
+static void unindex_booking(BookingList* list, int i) {
+    int start = SCHEDULE_AT(list, placed_start, i), end = SCHEDULE_AT(list, placed_end, i);
+    DayIndex* di = get_day_index(day_of(start), false);
+    if (!di) return;
+    int slot = SCHEDULE_AT(list, parking_slot, i);
+    if (slot >= 0 && slot < sys_res.parking_slots) {
+        timeline_remove(&di->slots[slot], start);
+        update_slot_blocks(di, slot, start, end, -1);
+    }
+    update_essentials(di, list, i, -1);
+    priority_remove(&di->accepted[BOOKING_AT(list, priority, i)], start, i);
+}
+
+// Peak usage of an essential over [start, end) of the day (0 for an empty range)
+static int essential_peak(const DayIndex* di, int res, int start, int end) {
+    if (start >= end || !di->essentials[res]) return 0;
+    int offset = di->day * MINUTES_PER_DAY;
+    return occupancy_max(di->essentials[res], 1, 0, OCCUPANCY_LEAVES, start - offset, end - offset);
+}
+
+// Essentials of booking i (pairs included) already at capacity while it is active
+static unsigned char full_essentials(BookingList* list, const DayIndex* di, int i) {
+    unsigned char essentials = with_pairs(BOOKING_AT(list, essentials, i));
+    int start = SCHEDULE_AT(list, placed_start, i), end = SCHEDULE_AT(list, placed_end, i);
+    unsigned char full = essentials & (1 << RES_UNKNOWN);
+    for (int res = 0; res < RESOURCE_TYPES; res++) {
+        if (!(essentials & (1 << res))) continue;
+        if (essential_peak(di, res, start, end) >= resource_capacity(res)) full |= 1 << res;
+    }
+    return full;
+}
+
+// Check if bookings involving essentials have conflict (0 -> no conflict, -1 -> has conflict)
+static int check_essential_conflict(BookingList* list, int i) {
+    if (with_pairs(BOOKING_AT(list, essentials, i)) == 0) return 0;
+    if (BOOKING_AT(list, essentials, i) & (1 << RES_UNKNOWN)) return -1;
+
+    DayIndex* di = get_day_index(day_of(SCHEDULE_AT(list, placed_start, i)), false);
+    if (!di) return 0;
+
+    // Peak usage of each essential while the booking is active
+    return full_essentials(list, di, i) ? -1 : 0;
+}
+
+// Check if the booking of parking has any conflict with accepted bookings
+// (0-N -> no conflict, indicate first avail parking slot, -1 -> has conflict)
+static int check_parking_conflict(BookingList* list, int i) {
+    int slot = SCHEDULE_AT(list, parking_slot, i);
+    int start = SCHEDULE_AT(list, placed_start, i), end = SCHEDULE_AT(list, placed_end, i);
+    DayIndex* di = get_day_index(day_of(start), false);
+    if (!di) {
+        // Nothing accepted on this date yet
+        return (slot >= 0 && slot < sys_res.parking_slots) ? slot : 0;
     }
 
-    // Assign the first available parking slot
-    for (int j = 0; j < MAX_SLOTS; j++) {
-        if (available_slots[j] == 1) {
-            return j;
+    // If the booking already has a valid parking slot, check if it is still available
+    if (slot >= 0 && slot < sys_res.parking_slots) {
+        if (timeline_is_free(&di->slots[slot], start, end)) {
+            return slot; // Keep the current slot if available
         }
     }
 
-    return -1; // No parking available
+    // Assign the first available parking slot (-1 -> no parking available)
+    return first_free_slot(di, start, end);
 }
 
-static bool has_time_conflict(Booking* item, Booking* bookings, int* acceptList, int acceptCount) {
-    if (strcmp(item->type, "*") == 0) {
+static bool has_time_conflict(BookingList* list, int i) {
+    if (BOOKING_AT(list, priority, i) == TYPE_ESSENTIALS) {
         // check essential conflict
-        return (check_essential_conflict(item, bookings, acceptList, acceptCount) == -1);
+        return (check_essential_conflict(list, i) == -1);
     } else {
         // check slot conflict
-        bool parking_conflict = (check_parking_conflict(item, bookings, acceptList, acceptCount) == -1);
-        bool essential_conflict = (check_essential_conflict(item, bookings, acceptList, acceptCount) == -1);    
+        bool parking_conflict = (check_parking_conflict(list, i) == -1);
+        bool essential_conflict = (check_essential_conflict(list, i) == -1);
         return parking_conflict || essential_conflict;
     }
 }
 
 // Cancel the bookings and release resources
-void cancelBooking(Booking* booking) {
-    booking->status = STATUS_REJECTED;
-    booking->parking_slot = -1;
+void cancelBooking(BookingList* list, int i) {
+    if (SCHEDULE_AT(list, status, i) == STATUS_ACCEPTED) {
+        unindex_booking(list, i);
+    }
+    SCHEDULE_AT(list, status, i) = STATUS_REJECTED;
+    SCHEDULE_AT(list, parking_slot, i) = -1;
 }
 
-static void create_booking(const char* member, const char* date, const char* time, float duration, char essentials[][MAX_STRING_LENGTH], int count, int slot, const char* type) {
-    if(duration == 0) {
-        printf("Error: Booking duration can't be 0, must be atleast 1 hour\n");
-        invalid_command_count++;
-        return;
-    }
+// Set the start and duration of a stored booking
+static void set_booking_time(int i, int start, float duration) {
+    float seconds = duration * 3600;
+    // round up so the range covers the last partial minute, ending by the last minute an int holds
+    long long end = seconds < (float)INT_MAX * 60 ? start + ((long long)seconds + 59) / 60 : INT_MAX;
+    BOOKING_AT(&allBookings, start, i) = start;
+    BOOKING_AT(&allBookings, end, i) = end < INT_MAX ? (int)end : INT_MAX;
+    BOOKING_AT(&allBookings, duration, i) = duration;
+}
 
-    Booking new_booking = {
-        .parking_slot = slot,
-        .status = STATUS_PENDING,
-        .start_time = convert_to_time_t(date, time),
-        .end_time = convert_to_time_t(date, time) + (time_t)(duration * 3600),
-        .essential_count = count,
-        .duration = duration
-    };
+// Append a parsed booking to the booking store
+static void create_booking(const BookingRequest* req) {
+    int n = allBookings.booking_count;
+    reserve_bookings(&allBookings, n + 1);
+    allBookings.booking_count++;
+    BOOKING_AT(&allBookings, member, n) = req->member;
+    BOOKING_AT(&allBookings, priority, n) = req->type;
+    BOOKING_AT(&allBookings, essentials, n) = req->essentials;
+    BOOKING_AT(&allBookings, cancelled, n) = 0;
+    set_booking_time(n, req->start, req->duration);
+    journal_booking(JOURNAL_ADD, n);
+}
 
-    strncpy(new_booking.member, member, MAX_STRING_LENGTH-1);
-    strncpy(new_booking.date, date, sizeof(new_booking.date)-1);
-    strncpy(new_booking.time, time, sizeof(new_booking.time)-1);
-    strncpy(new_booking.type, type, sizeof(new_booking.type)-1);
+// Add a booking to the day's partition, after the ones that arrived before it
+static void add_pending(DayIndex* di, int i) {
+    if (di->pending_count == di->pending_capacity) {
+        int new_capacity = di->pending_capacity ? di->pending_capacity * 2 : 16;
+        int* pending = realloc(di->pending, new_capacity * sizeof(int));
+        if (!pending) {
+            fprintf(stderr, "Failed to allocate memory.\n");
+            exit(1);
+        }
+        di->pending = pending;
+        di->pending_capacity = new_capacity;
+    }
+    di->pending[di->pending_count++] = i;
+}
 
-    for (int i = 0; i < count; i++) {
-        strncpy(new_booking.essentials[i], essentials[i], MAX_STRING_LENGTH-1);
+// Append a position to the day's accept list, added while scheduling booking key
+static int add_accept_slot(DayIndex* di, int key) {
+    if (di->accept_count == di->accept_capacity) {
+        int new_capacity = di->accept_capacity ? di->accept_capacity * 2 : 16;
+        int* accept_list = realloc(di->accept_list, new_capacity * sizeof(int));
+        if (accept_list) di->accept_list = accept_list;
+        int* accept_keys = realloc(di->accept_keys, new_capacity * sizeof(int));
+        if (accept_keys) di->accept_keys = accept_keys;
+        if (!accept_list || !accept_keys) {
+            fprintf(stderr, "Failed to allocate memory.\n");
+            exit(1);
+        }
+        di->accept_capacity = new_capacity;
     }
+    di->accept_keys[di->accept_count] = key;
+    return di->accept_count++;
+}
 
-    allBookings.bookings[allBookings.booking_count++] = new_booking;
+static int compare_waitlist(const void* a, const void* b) {
+    const PriorityEntry* x = a;
+    const PriorityEntry* y = b;
+    if (x->start != y->start) return x->start < y->start ? -1 : 1;
+    return (x->booking > y->booking) - (x->booking < y->booking);
 }
 
-static bool time_overlap(Booking* booking1, Booking* booking2) {
-    // Check if the dates are the same
-    if (strcmp(booking1->date, booking2->date) != 0) return false; // Different dates, no overlap
+// Rebuild the day's waitlist from its rejected bookings after a scheduling run.
+// A moved booking may be listed in the partitions of several days, only its current day keeps it.
+static void build_waitlist(BookingList* list, DayIndex* di) {
+    PriorityTimeline* wl = &di->waitlist;
+    wl->count = 0;
+    wl->max_length = 0;
+    for (int k = 0; k < di->pending_count; k++) {
+        int i = di->pending[k];
+        if (SCHEDULE_AT(list, status, i) != STATUS_REJECTED || BOOKING_AT(list, cancelled, i)) continue;
+        if (day_of(SCHEDULE_AT(list, placed_start, i)) != di->day) continue;
+        if (wl->count == wl->capacity) {
+            int new_capacity = wl->capacity ? wl->capacity * 2 : 8;
+            PriorityEntry* items = realloc(wl->items, new_capacity * sizeof(PriorityEntry));
+            if (!items) {
+                fprintf(stderr, "Failed to allocate memory.\n");
+                exit(1);
+            }
+            wl->items = items;
+            wl->capacity = new_capacity;
+        }
+        PriorityEntry* entry = &wl->items[wl->count++];
+        entry->start = SCHEDULE_AT(list, placed_start, i);
+        entry->end = SCHEDULE_AT(list, placed_end, i);
+        entry->booking = i;
+    }
+    qsort(wl->items, wl->count, sizeof(PriorityEntry), compare_waitlist);
 
-    // Check if the time intervals overlap
-    return (booking1->start_time < booking2->end_time && booking2->start_time < booking1->end_time);
+    int kept = 0;
+    for (int k = 0; k < wl->count; k++) {
+        if (kept > 0 && wl->items[kept - 1].booking == wl->items[k].booking) continue;
+        wl->items[kept++] = wl->items[k];
+        if (wl->items[k].end - wl->items[k].start > wl->max_length) wl->max_length = wl->items[k].end - wl->items[k].start;
+    }
+    wl->count = kept;
 }
 
-// FCFS Algirhtm Function
-void FCFS_Scheduler(Booking* bookings, int numBookings, int* acceptList, int* acceptCounter) {
-    for (int i = 0; i < numBookings; i++) {
-        if (bookings[i].status != STATUS_PENDING) continue;
+// FCFS Algirhtm Function (schedules the day's bookings not scheduled yet)
+void FCFS_Scheduler(BookingList* list, DayIndex* di) {
+    for (int k = di->scheduled; k < di->pending_count; k++) {
+        int i = di->pending[k];
+        if (SCHEDULE_AT(list, status, i) != STATUS_PENDING) continue;
 
         // Only non-" *" types need to be allocated parking Spaces
-        if (strcmp(bookings[i].type, "*") != 0) {
-            if (bookings[i].parking_slot == -1) {
-                bookings[i].parking_slot = check_parking_conflict(&bookings[i], bookings, acceptList, *acceptCounter);
+        if (BOOKING_AT(list, priority, i) != TYPE_ESSENTIALS) {
+            if (SCHEDULE_AT(list, parking_slot, i) == -1) {
+                SCHEDULE_AT(list, parking_slot, i) = check_parking_conflict(list, i);
             }
             // Refuse when the parking space is invalid
-            if (bookings[i].parking_slot == -1) {
-                cancelBooking(&bookings[i]);
+            if (SCHEDULE_AT(list, parking_slot, i) == -1) {
+                cancelBooking(list, i);
                 continue;
             }
         }
 
         // Checking for conflict
-        if (!has_time_conflict(&bookings[i], bookings, acceptList, *acceptCounter)) {
-            bookings[i].status = STATUS_ACCEPTED;
-            acceptList[(*acceptCounter)++] = i;
+        if (!has_time_conflict(list, i)) {
+            SCHEDULE_AT(list, status, i) = STATUS_ACCEPTED;
+            int pos = add_accept_slot(di, i);
+            SCHEDULE_AT(list, accept_pos, i) = pos;
+            di->accept_list[pos] = i;
+            index_booking(list, i);
         } else {
-            cancelBooking(&bookings[i]);
+            cancelBooking(list, i);
         }
     }
+    di->scheduled = di->pending_count;
+    build_waitlist(list, di);
 }
 
-//Priority Algorithm Function
-void Priority_Scheduler(Booking* bookings, int numBookings, int* acceptList, int* acceptCounter) {
-
-    for (int i = 0; i < numBookings; i++) {
-        // Process only pending bookings
-        if (bookings[i].status != STATUS_PENDING) continue;
-
-        // Debug: Print booking details and priority
-        int priority = get_priority_level(bookings[i].type);
+// What keeps a booking out of the schedule, the room a preemption has to make
+typedef struct Blocking {
+    bool slot;                  // no parking slot is free
+    unsigned char essentials;   // essentials (pairs included) at capacity
+    int full_start, full_end;   // span of the minutes at capacity, set by find_full_span
+} Blocking;
+
+// Find what blocks booking i (nothing when it fits), a booking with parking keeps the free slot found
+static Blocking find_blocking(BookingList* list, DayIndex* di, int i) {
+    Blocking b = {false, 0, 0, 0};
+    if (BOOKING_AT(list, priority, i) != TYPE_ESSENTIALS) {
+        SCHEDULE_AT(list, parking_slot, i) = check_parking_conflict(list, i);
+        b.slot = SCHEDULE_AT(list, parking_slot, i) == -1;
+    }
+    b.essentials = full_essentials(list, di, i);
+    return b;
+}
 
-        bool canAccept = !has_time_conflict(&bookings[i], bookings, acceptList, *acceptCounter);
+// Find the span of the minutes of booking i where a blocking essential is at capacity
+static void find_full_span(BookingList* list, DayIndex* di, int i, Blocking* b) {
+    int offset = di->day * MINUTES_PER_DAY;
+    int start = SCHEDULE_AT(list, placed_start, i) - offset, end = SCHEDULE_AT(list, placed_end, i) - offset;
+    b->full_start = end;
+    b->full_end = start;
+    for (int res = 0; res < RESOURCE_TYPES; res++) {
+        if (!(b->essentials & (1 << res))) continue;
+        int capacity = resource_capacity(res);
+        int first = occupancy_find(di->essentials[res], 1, 0, OCCUPANCY_LEAVES, start, end, capacity, false);
+        int last = occupancy_find(di->essentials[res], 1, 0, OCCUPANCY_LEAVES, start, end, capacity, true);
+        if (first >= 0 && first < b->full_start) b->full_start = first;
+        if (last >= 0 && last + 1 > b->full_end) b->full_end = last + 1;
+    }
+    b->full_start += offset;
+    b->full_end += offset;
+}
 
-        // Accept or reject the booking
-        if (canAccept) {
-            bookings[i].status = STATUS_ACCEPTED;
-            acceptList[(*acceptCounter)++] = i;
-            if(strcmp(bookings[i].type, "*") != 0) {
-                bookings[i].parking_slot = check_parking_conflict(&bookings[i], bookings, acceptList, *acceptCounter);
+// Accepted bookings of the day overlapping booking i with a lower priority that could make room for it,
+// lowest priority first. Usage never exceeds capacity, so an eviction frees an essential at capacity
+// only when the victim holds it throughout the minutes it is full.
+// (found is grown as needed and reused by the next call)
+static int find_preemption_victims(BookingList* list, DayIndex* di, int i, Blocking* b,
+                                   int** found, int* found_capacity) {
+    int count = 0;
+    bool span_known = false;
+    int start = SCHEDULE_AT(list, placed_start, i), end = SCHEDULE_AT(list, placed_end, i);
+    for (int p = 0; p < BOOKING_AT(list, priority, i); p++) {
+        PriorityTimeline* pt = &di->accepted[p];
+        for (int k = priority_lower_bound(pt, start - pt->max_length + 1); k < pt->count && pt->items[k].start < end; k++) {
+            if (pt->items[k].end <= start) continue;
+            int v = pt->items[k].booking;
+            if (b->slot && SCHEDULE_AT(list, parking_slot, v) < 0) continue;
+            if (b->essentials) {
+                if (b->essentials & ~with_pairs(BOOKING_AT(list, essentials, v))) continue;
+                if (!span_known) {
+                    find_full_span(list, di, i, b);
+                    span_known = true;
+                }
+                if (pt->items[k].start > b->full_start || pt->items[k].end < b->full_end) continue;
             }
-        } 
-        
-        else {
-            // Check if the booking can replace a lower-priority booking
-            int lowestPriorityIndex = -1;
-            int currPriority = priority;
-
-            for (int j = *acceptCounter - 1; j >= 0; j--) { // Iterate from the back
-                int acceptedIndex = acceptList[j]; // access accepted indexes from accept list
-                if(!time_overlap(&bookings[i], &bookings[acceptedIndex])) continue;
-
-                int acceptedPriority = get_priority_level(bookings[acceptedIndex].type);
-                // detect & store first detected lower priority
-                if (acceptedPriority < currPriority) {
-                    // currPriority = acceptedPriority;
-                    lowestPriorityIndex = j;
+            if (count == *found_capacity) {
+                int new_capacity = *found_capacity ? *found_capacity * 2 : 16;
+                int* grown = realloc(*found, new_capacity * sizeof(int));
+                if (!grown) {
+                    fprintf(stderr, "Failed to allocate memory.\n");
+                    exit(1);
                 }
+                *found = grown;
+                *found_capacity = new_capacity;
             }
+            (*found)[count++] = v;
+        }
+    }
+    return count;
+}
 
-            if (lowestPriorityIndex != -1) { // found a lower priority
-                // Replace the lowest-priority booking
-                int replacedIndex = acceptList[lowestPriorityIndex];
+// Accept booking i at position pos of the day's accept list
+static void accept_booking(BookingList* list, DayIndex* di, int i, int pos) {
+    if (BOOKING_AT(list, priority, i) != TYPE_ESSENTIALS) {
+        SCHEDULE_AT(list, parking_slot, i) = check_parking_conflict(list, i);
+    }
+    SCHEDULE_AT(list, status, i) = STATUS_ACCEPTED;
+    SCHEDULE_AT(list, accept_pos, i) = pos;
+    di->accept_list[pos] = i;
+    index_booking(list, i);
+}
 
-                bookings[i].parking_slot = bookings[replacedIndex].parking_slot;
-                bookings[i].status = STATUS_ACCEPTED;
-                cancelBooking(&bookings[replacedIndex]);
+// Outcome of evicting an accepted booking in favour of another
+enum {
+    PREEMPT_NO_ROOM,    // the booking still does not fit
+    PREEMPT_EVICTS,     // the booking fits, the victim stays rejected
+    PREEMPT_REPLACES    // the booking fits and the victim fits again elsewhere
+};
 
-                acceptList[lowestPriorityIndex] = i;
-            }
-            else {
-                cancelBooking(&bookings[i]);
-            }
-        }
+// Check, without touching the indexes, what evicting a victim found by find_preemption_victims does for booking i
+static int preemption_outcome(BookingList* list, DayIndex* di, int i, int victim, const Blocking* b) {
+    int start = SCHEDULE_AT(list, placed_start, i), end = SCHEDULE_AT(list, placed_end, i);
+    int victimStart = SCHEDULE_AT(list, placed_start, victim), victimEnd = SCHEDULE_AT(list, placed_end, victim);
+    int victimSlot = SCHEDULE_AT(list, parking_slot, victim);
+
+    // Booking i takes over the victim's slot when nothing else holds it meanwhile
+    bool takes_slot = BOOKING_AT(list, priority, i) != TYPE_ESSENTIALS &&
+                      victimSlot >= 0 && victimSlot < sys_res.parking_slots &&
+                      timeline_is_free_without(&di->slots[victimSlot], start, end, victimStart);
+    if (b->slot && !takes_slot) return PREEMPT_NO_ROOM;
+
+    // The victim keeps its slot unless i takes it, then it needs another free one
+    if (takes_slot && first_free_slot(di, victimStart, victimEnd) == -1) return PREEMPT_EVICTS;
+
+    // Essentials both hold are used by i instead of the victim while they overlap
+    unsigned char shared = with_pairs(BOOKING_AT(list, essentials, victim)) & with_pairs(BOOKING_AT(list, essentials, i));
+    int overlapStart = start > victimStart ? start : victimStart;
+    int overlapEnd = end < victimEnd ? end : victimEnd;
+    for (int res = 0; res < RESOURCE_TYPES; res++) {
+        if (!(shared & (1 << res))) continue;
+        if (essential_peak(di, res, overlapStart, overlapEnd) >= resource_capacity(res)) return PREEMPT_EVICTS;
     }
+    return PREEMPT_REPLACES;
 }
 
-/* Input Module Functions */
-//functions for adding bookings
-void add_parking(char *member, char *date, char *time, float duration, char essentials[][MAX_STRING_LENGTH], int count) {
-    if (!validate_datetime(date, time)) {
-        printf("Error: Invalid date/time format\n");
-        invalid_command_count++;
-        return;
+// Evict the accepted booking victim in favour of booking i (checked by preemption_outcome).
+// The victim is re-placed into any capacity left.
+static void preempt(BookingList* list, DayIndex* di, int i, int victim) {
+    int victimSlot = SCHEDULE_AT(list, parking_slot, victim);
+    int pos = SCHEDULE_AT(list, accept_pos, victim);
+    cancelBooking(list, victim);
+
+    // Take over the released slot when the booking fits in it
+    if (BOOKING_AT(list, priority, i) != TYPE_ESSENTIALS) {
+        SCHEDULE_AT(list, parking_slot, i) = victimSlot;
     }
+    accept_booking(list, di, i, pos);
 
-    create_booking(member, date, time, duration, essentials, count, -1, "Parking");
-    printf("-> [Pending]");
+    // Re-place the evicted booking into any capacity that is left
+    if (!has_time_conflict(list, victim)) {
+        accept_booking(list, di, victim, add_accept_slot(di, i));
+    }
 }
 
-void add_reservation(char *member, char *date, char *time, float duration, char essentials[][MAX_STRING_LENGTH], int count) {
-    if (!validate_datetime(date, time)) {
-        printf("Invalid date/time format\n");
-        invalid_command_count++;
-        return;
+//Priority Algorithm Function (schedules the day's bookings not scheduled yet)
+void Priority_Scheduler(BookingList* list, DayIndex* di) {
+    int* victims = NULL;
+    int victim_capacity = 0;
+
+    for (int k = di->scheduled; k < di->pending_count; k++) {
+        int i = di->pending[k];
+        // Process only pending bookings
+        if (SCHEDULE_AT(list, status, i) != STATUS_PENDING) continue;
+
+        Blocking blocking = find_blocking(list, di, i);
+        if (!blocking.slot && !blocking.essentials) {
+            accept_booking(list, di, i, add_accept_slot(di, i));
+            continue;
+        }
+
+        // Check if the booking can replace a lower-priority booking. Prefer a victim
+        // that fits elsewhere, so the preemption does not cost an accepted booking.
+        int victim_count = find_preemption_victims(list, di, i, &blocking, &victims, &victim_capacity);
+        int chosen = -1, fallback = -1;
+        for (int v = 0; v < victim_count && chosen < 0; v++) {
+            int outcome = preemption_outcome(list, di, i, victims[v], &blocking);
+            if (outcome == PREEMPT_REPLACES) chosen = victims[v];
+            else if (outcome == PREEMPT_EVICTS && fallback < 0) fallback = victims[v];
+        }
+        if (chosen < 0) chosen = fallback;
+
+        if (chosen >= 0) {
+            preempt(list, di, i, chosen);
+        } else {
+            cancelBooking(list, i);
+        }
     }
+    di->scheduled = di->pending_count;
+    build_waitlist(list, di);
+    free(victims);
+}
 
-    create_booking(member, date, time, duration, essentials, count, -1, "Reservation");
-    printf("-> [Pending]");
+static int compare_keys(const void* a, const void* b) {
+    long long x = *(const long long*)a, y = *(const long long*)b;
+    return (x > y) - (x < y);
 }
 
-void book_essentials(char *member, char *date, char *time, float duration, char essentials[][MAX_STRING_LENGTH], int count) {
-    if (!validate_datetime(date, time)) {
-        printf("Invalid date/time format\n");
-        invalid_command_count++;
-        return;
+// Accept waitlisted bookings of the day that fit into the capacity freed in [start, end).
+// FCFS takes them in arrival order, priority scheduling the highest priority first.
+static void promote_waitlist(BookingList* list, DayIndex* di, int start, int end, bool priority) {
+    PriorityTimeline* wl = &di->waitlist;
+    int first = priority_lower_bound(wl, start - wl->max_length + 1);
+    int count = 0;
+    for (int k = first; k < wl->count && wl->items[k].start < end; k++) {
+        if (wl->items[k].end > start) count++;
     }
+    if (count == 0) return;
 
-    create_booking(member, date, time, duration, essentials, count, -1, "*");
-    printf("-> [Pending]");
+    long long* order = malloc(count * sizeof(long long));
+    if (!order) {
+        fprintf(stderr, "Failed to allocate memory.\n");
+        exit(1);
+    }
+    count = 0;
+    for (int k = first; k < wl->count && wl->items[k].start < end; k++) {
+        if (wl->items[k].end <= start) continue;
+        int i = wl->items[k].booking;
+        long long rank = priority ? PRIORITY_LEVELS - 1 - BOOKING_AT(list, priority, i) : 0;
+        order[count++] = rank << 32 | i;
+    }
+    qsort(order, count, sizeof(long long), compare_keys);
+
+    for (int k = 0; k < count; k++) {
+        int i = (int)(order[k] & 0xFFFFFFFF);
+        SCHEDULE_AT(list, parking_slot, i) = -1;
+        if (has_time_conflict(list, i)) continue;
+        priority_remove(wl, SCHEDULE_AT(list, placed_start, i), i);
+        accept_booking(list, di, i, add_accept_slot(di, i));
+    }
+    free(order);
 }
 
-void add_event(char *member, char *date, char *time, float duration, char essentials[][MAX_STRING_LENGTH], int count) {
-    if (!validate_datetime(date, time)) {
-        printf("Invalid date/time format\n");
-        invalid_command_count++;
+// A cancelBooking or modifyBooking as the parent applied it to the store. The Scheduler
+// workers take the times from here, the parent may already be changing the store again.
+typedef struct BookingUpdate {
+    int booking;
+    int old_start, old_end;         // times the booking was scheduled with
+    int new_start, new_end;         // times it has now (unused when cancelled)
+    int cancelled;
+} BookingUpdate;
+
+// Apply a cancelBooking or modifyBooking of a scheduled booking: release its place, put a
+// moved booking on its new day (accepted if it fits, else waitlisted), then promote
+// waitlisted bookings into the capacity it freed. Only the two days involved are touched.
+static void reschedule_booking(BookingList* list, const BookingUpdate* update, bool priority) {
+    int i = update->booking;
+    int old_start = update->old_start, old_end = update->old_end;
+    DayIndex* old_day = get_day_index(day_of(old_start), true);
+    bool was_accepted = SCHEDULE_AT(list, status, i) == STATUS_ACCEPTED;
+    if (was_accepted) {
+        unindex_booking(list, i);
+        old_day->accept_list[SCHEDULE_AT(list, accept_pos, i)] = -1; // skipped by the merge
+    } else {
+        priority_remove(&old_day->waitlist, old_start, i);
+    }
+    SCHEDULE_AT(list, status, i) = STATUS_REJECTED;
+    SCHEDULE_AT(list, parking_slot, i) = -1;
+
+    if (!update->cancelled) {
+        SCHEDULE_AT(list, placed_start, i) = update->new_start;
+        SCHEDULE_AT(list, placed_end, i) = update->new_end;
+        DayIndex* day = get_day_index(day_of(update->new_start), true);
+        add_pending(day, i);
+        day->scheduled = day->pending_count;
+        if (!has_time_conflict(list, i)) {
+            accept_booking(list, day, i, add_accept_slot(day, i));
+        } else {
+            priority_insert(&day->waitlist, update->new_start, update->new_end, i);
+        }
+    }
+
+    if (was_accepted) promote_waitlist(list, old_day, old_start, old_end, priority);
+}
+
+// Booking of the day considered by Opti_Scheduler
+typedef struct OptiItem {
+    int start;
+    int end;
+    long long weight;               // booked minutes times the priority level (1 essentials only .. 4 event)
+    int booking;
+} OptiItem;
+
+static int compare_opti_end(const void* a, const void* b) {
+    const OptiItem* x = a;
+    const OptiItem* y = b;
+    if (x->end != y->end) return x->end < y->end ? -1 : 1;
+    if (x->start != y->start) return x->start < y->start ? -1 : 1;
+    return (x->booking > y->booking) - (x->booking < y->booking);
+}
+
+static int compare_opti_start(const void* a, const void* b) {
+    const OptiItem* x = a;
+    const OptiItem* y = b;
+    if (x->start != y->start) return x->start < y->start ? -1 : 1;
+    if (x->weight != y->weight) return x->weight > y->weight ? -1 : 1;
+    return (x->booking > y->booking) - (x->booking < y->booking);
+}
+
+static int compare_opti_weight(const void* a, const void* b) {
+    const OptiItem* x = a;
+    const OptiItem* y = b;
+    if (x->weight != y->weight) return x->weight > y->weight ? -1 : 1;
+    return (x->booking > y->booking) - (x->booking < y->booking);
+}
+
+// Accept booking i of the day on the given slot (-1 for essentials only) if its essentials fit
+static bool opti_accept(BookingList* list, DayIndex* di, int i, int slot) {
+    if (check_essential_conflict(list, i) == -1) return false;
+    SCHEDULE_AT(list, parking_slot, i) = slot;
+    accept_booking(list, di, i, add_accept_slot(di, i));
+    return true;
+}
+
+// Parking slot with the earliest free time on top
+typedef struct SlotFree {
+    int free;
+    int slot;
+} SlotFree;
+
+static void slot_heap_down(SlotFree* heap, int count, int k) {
+    for (;;) {
+        int c = 2 * k + 1;
+        if (c >= count) return;
+        if (c + 1 < count && heap[c + 1].free < heap[c].free) c++;
+        if (heap[k].free <= heap[c].free) return;
+        SlotFree t = heap[k];
+        heap[k] = heap[c];
+        heap[c] = t;
+        k = c;
+    }
+}
+
+static int compare_minutes(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Most bookings active at the same time, of bookings sorted by end (starts is scratch for count ints)
+static int opti_overlap(const OptiItem* items, int count, int* starts) {
+    for (int k = 0; k < count; k++) starts[k] = items[k].start;
+    qsort(starts, count, sizeof(int), compare_minutes);
+    int active = 0, most = 0;
+    for (int k = 0, e = 0; k < count; k++) {
+        while (items[e].end <= starts[k]) {
+            e++;
+            active--;
+        }
+        if (++active > most) most = active;
+    }
+    return most;
+}
+
+// Opti Algorithm Function (schedules all bookings of the day again, so new bookings can take
+// any place). Maximizes the booked time weighted by priority level. While the bookings left
+// overlap more than the slots left, the next slot (up to OPTI_EXACT_SLOTS) takes the heaviest
+// set of disjoint bookings left (weighted interval scheduling over the bookings sorted by end,
+// with a binary search for the last compatible one). Then the bookings left take the slots left
+// in start order from a min-heap of slot free times, which places all of them once they fit.
+// So a day within capacity costs O(N log N), an oversubscribed one up to OPTI_EXACT_SLOTS times
+// that. Bookings whose essentials are taken stay rejected, and essentials-only bookings are
+// accepted heaviest first into the essentials left.
+void Opti_Scheduler(BookingList* list, DayIndex* di) {
+    reset_day_index(di);
+
+    OptiItem* items = malloc((di->pending_count + 1) * sizeof(OptiItem));
+    long long* best = malloc((di->pending_count + 1) * sizeof(long long));
+    int* prev = malloc((di->pending_count + 1) * sizeof(int));
+    if (!items || !best || !prev) {
+        fprintf(stderr, "Failed to allocate memory.\n");
+        exit(1);
+    }
+
+    // Bookings placed on this day; a moved booking may be listed on several days, or twice
+    int count = 0;
+    for (int k = 0; k < di->pending_count; k++) {
+        int i = di->pending[k];
+        if (BOOKING_AT(list, cancelled, i)) continue;
+        if (day_of(SCHEDULE_AT(list, placed_start, i)) != di->day) continue;
+        SCHEDULE_AT(list, status, i) = STATUS_REJECTED;
+        SCHEDULE_AT(list, parking_slot, i) = -1;
+        OptiItem* item = &items[count++];
+        item->start = SCHEDULE_AT(list, placed_start, i);
+        item->end = SCHEDULE_AT(list, placed_end, i);
+        item->weight = (long long)(item->end - item->start) * (BOOKING_AT(list, priority, i) + 1);
+        item->booking = i;
+    }
+    qsort(items, count, sizeof(OptiItem), compare_opti_end);
+    int kept = 0, parking = 0;
+    for (int k = 0; k < count; k++) {
+        if (kept > 0 && items[kept - 1].booking == items[k].booking) continue;
+        items[kept++] = items[k];
+    }
+    count = kept;
+
+    // Parking bookings first (in end order), essentials-only ones after them
+    OptiItem* essentials_only = malloc((count + 1) * sizeof(OptiItem));
+    if (!essentials_only) {
+        fprintf(stderr, "Failed to allocate memory.\n");
+        exit(1);
+    }
+    int essentials_count = 0;
+    for (int k = 0; k < count; k++) {
+        if (BOOKING_AT(list, priority, items[k].booking) == TYPE_ESSENTIALS) essentials_only[essentials_count++] = items[k];
+        else items[parking++] = items[k];
+    }
+
+    // The overlap of the bookings left exceeds the slots left by at least excess. A slot lowers
+    // the overlap by one at most, so only dropped bookings can make the rest fit.
+    int slot = 0, excess = 0;
+    while (slot < sys_res.parking_slots && slot < OPTI_EXACT_SLOTS && parking > 0) {
+        if (excess <= 0) {
+            excess = opti_overlap(items, parking, prev) - (sys_res.parking_slots - slot);
+            if (excess <= 0) break;
+        }
+
+        // best[j]: heaviest disjoint set among the first j bookings, prev[j]: bookings
+        // ending by the start of booking j, or -1 when the best set skips booking j
+        best[0] = 0;
+        for (int j = 0; j < parking; j++) {
+            int lo = 0, hi = j;
+            while (lo < hi) {
+                int mid = (lo + hi) / 2;
+                if (items[mid].end <= items[j].start) lo = mid + 1;
+                else hi = mid;
+            }
+            long long take = best[lo] + items[j].weight;
+            if (take > best[j]) {
+                best[j + 1] = take;
+                prev[j] = lo;
+            } else {
+                best[j + 1] = best[j];
+                prev[j] = -1;
+            }
+        }
+
+        // Mark the chosen bookings by negating their weight
+        for (int j = parking; j > 0;) {
+            if (prev[j - 1] < 0) {
+                j--;
+                continue;
+            }
+            items[j - 1].weight = -items[j - 1].weight;
+            j = prev[j - 1];
+        }
+
+        // Bookings in one slot never overlap, so only the slots filled before can take their
+        // essentials. Essentials only fill up: a booking without them is rejected for good, and
+        // the slot is filled again from the bookings left.
+        unsigned char full = 0;
+        for (int j = 0; j < parking; j++) {
+            if (items[j].weight < 0 && check_essential_conflict(list, items[j].booking) == -1) {
+                full |= with_pairs(BOOKING_AT(list, essentials, items[j].booking));
+            }
+        }
+        if (full) {
+            // Drop every booking left that needs one of the essentials found full
+            kept = 0;
+            for (int j = 0; j < parking; j++) {
+                if (items[j].weight < 0) items[j].weight = -items[j].weight;
+                if ((with_pairs(BOOKING_AT(list, essentials, items[j].booking)) & full) &&
+                    check_essential_conflict(list, items[j].booking) == -1) continue;
+                items[kept++] = items[j];
+            }
+            excess -= parking - kept;
+            parking = kept;
+            continue;
+        }
+
+        // Place the chosen bookings in end order
+        kept = 0;
+        for (int j = 0; j < parking; j++) {
+            if (items[j].weight >= 0) items[kept++] = items[j];
+            else opti_accept(list, di, items[j].booking, slot);
+        }
+        parking = kept;
+        slot++;
+    }
+
+    if (slot < sys_res.parking_slots && parking > 0) {
+        SlotFree* heap = malloc((sys_res.parking_slots - slot) * sizeof(SlotFree));
+        if (!heap) {
+            fprintf(stderr, "Failed to allocate memory.\n");
+            exit(1);
+        }
+        int heap_count = 0;
+        for (int s = slot; s < sys_res.parking_slots; s++) {
+            heap[heap_count].free = di->day * MINUTES_PER_DAY;
+            heap[heap_count++].slot = s;
+        }
+        qsort(items, parking, sizeof(OptiItem), compare_opti_start);
+        for (int j = 0; j < parking; j++) {
+            if (heap[0].free > items[j].start) continue; // every slot is still taken
+            if (!opti_accept(list, di, items[j].booking, heap[0].slot)) continue;
+            heap[0].free = items[j].end;
+            slot_heap_down(heap, heap_count, 0);
+        }
+        free(heap);
+    }
+
+    qsort(essentials_only, essentials_count, sizeof(OptiItem), compare_opti_weight);
+    for (int j = 0; j < essentials_count; j++) {
+        opti_accept(list, di, essentials_only[j].booking, -1);
+    }
+
+    di->scheduled = di->pending_count;
+    free(essentials_only);
+    free(items);
+    free(best);
+    free(prev);
+}
+
+// Apply a cancelBooking or modifyBooking to the opti schedule. Its best schedule of a day can
+// change anywhere, so the days the booking leaves and joins are scheduled again on the next run.
+static void requeue_booking(BookingList* list, const BookingUpdate* update) {
+    int i = update->booking;
+    DayIndex* old_day = get_day_index(day_of(update->old_start), true);
+    old_day->scheduled = 0;
+    SCHEDULE_AT(list, status, i) = STATUS_REJECTED;
+    SCHEDULE_AT(list, parking_slot, i) = -1;
+
+    if (!update->cancelled) {
+        SCHEDULE_AT(list, placed_start, i) = update->new_start;
+        SCHEDULE_AT(list, placed_end, i) = update->new_end;
+        DayIndex* day = get_day_index(day_of(update->new_start), true);
+        add_pending(day, i);
+        day->scheduled = 0;
+    }
+}
+
+// Days with bookings to schedule, shared by the scheduling threads
+typedef struct ScheduleQueue {
+    BookingList* list;
+    DayIndex** days;
+    int day_count;
+    int next;                       // next day to take, advanced atomically
+    int algorithm;                  // ALGORITHM_*
+} ScheduleQueue;
+
+static void* schedule_days(void* arg) {
+    ScheduleQueue* queue = arg;
+    int d;
+    while ((d = __atomic_fetch_add(&queue->next, 1, __ATOMIC_RELAXED)) < queue->day_count) {
+        if (queue->algorithm == ALGORITHM_PRIO) Priority_Scheduler(queue->list, queue->days[d]);
+        else if (queue->algorithm == ALGORITHM_OPTI) Opti_Scheduler(queue->list, queue->days[d]);
+        else FCFS_Scheduler(queue->list, queue->days[d]);
+    }
+    return NULL;
+}
+
+// Merge the accept lists of the days into the order a single pass over all bookings
+// gives: positions are appended in order of the booking being scheduled (their key),
+// and a key only ever adds positions to its own day. Positions freed by cancelBooking
+// or modifyBooking hold -1 and are left out. Returns the number of bookings.
+static int merge_accept_lists(int booking_count, int* acceptList) {
+    int* offsets = calloc(booking_count + 1, sizeof(int));
+    if (!offsets) {
+        fprintf(stderr, "Failed to allocate memory.\n");
+        exit(1);
+    }
+    for (int h = 0; h < conflict_index.capacity; h++) {
+        DayIndex* di = conflict_index.days[h];
+        if (!di) continue;
+        for (int p = 0; p < di->accept_count; p++) {
+            if (di->accept_list[p] >= 0) offsets[di->accept_keys[p] + 1]++;
+        }
+    }
+    for (int k = 0; k < booking_count; k++) offsets[k + 1] += offsets[k];
+    int total = offsets[booking_count];
+    for (int h = 0; h < conflict_index.capacity; h++) {
+        DayIndex* di = conflict_index.days[h];
+        if (!di) continue;
+        for (int p = 0; p < di->accept_count; p++) {
+            if (di->accept_list[p] >= 0) acceptList[offsets[di->accept_keys[p]]++] = di->accept_list[p];
+        }
+    }
+    free(offsets);
+    return total;
+}
+
+// Schedule the bookings from index 'from' on with the given algorithm. Bookings on different
+// days never conflict, so they are split by day in arrival order and the days are scheduled
+// on up to one thread per core. Fills acceptList with all accepted bookings and returns their number.
+static int schedule_bookings(BookingList* list, int from, int algorithm, int* acceptList) {
+    for (int i = from; i < list->booking_count; i++) {
+        if (BOOKING_AT(list, cancelled, i)) continue; // cancelled before it was ever scheduled
+        add_pending(get_day_index(day_of(SCHEDULE_AT(list, placed_start, i)), true), i);
+    }
+
+    // The day table is complete, the threads only look days up
+    ScheduleQueue queue = {list, malloc((conflict_index.day_count + 1) * sizeof(DayIndex*)), 0, 0, algorithm};
+    if (!queue.days) {
+        fprintf(stderr, "Failed to allocate memory.\n");
+        exit(1);
+    }
+    for (int h = 0; h < conflict_index.capacity; h++) {
+        DayIndex* di = conflict_index.days[h];
+        if (di && di->scheduled < di->pending_count) queue.days[queue.day_count++] = di;
+    }
+
+    long thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+    if (thread_count > MAX_SCHEDULE_THREADS) thread_count = MAX_SCHEDULE_THREADS;
+    if (thread_count > queue.day_count) thread_count = queue.day_count;
+    if (list->booking_count - from < SCHEDULE_PARALLEL_MIN) thread_count = 1;
+
+    pthread_t threads[MAX_SCHEDULE_THREADS];
+    int started = 0;
+    for (int t = 1; t < thread_count; t++) {
+        if (pthread_create(&threads[started], NULL, schedule_days, &queue) == 0) started++;
+    }
+    schedule_days(&queue); // the calling thread takes days too, and finishes them if no thread started
+    for (int t = 0; t < started; t++) pthread_join(threads[t], NULL);
+    free(queue.days);
+
+    return merge_accept_lists(list->booking_count, acceptList);
+}
+
+/* Input Module Functions */
+// Part of a command line, not NUL-terminated
+typedef struct StrView {
+    const char* ptr;
+    int len;
+} StrView;
+
+// Next space-separated token of [*cur, end), false at the end of the line. The ';' ending
+// the command is left out of the last token, and one on its own is no token.
+static bool next_token(const char** cur, const char* end, StrView* token) {
+    const char* p = *cur;
+    while (p < end && *p == ' ') p++;
+    if (p == end) return false;
+    token->ptr = p;
+    while (p < end && *p != ' ') p++;
+    token->len = (int)(p - token->ptr);
+    *cur = p;
+    while (p < end && *p == ' ') p++;
+    if (p == end && token->ptr[token->len - 1] == ';' && --token->len == 0) return false;
+    return true;
+}
+
+// Whether the command in [line, end) ends with a ';'
+static bool ends_command(const char* line, const char* end) {
+    while (end > line && end[-1] == ' ') end--;
+    return end > line && end[-1] == ';';
+}
+
+static bool view_equals(StrView view, const char* str) {
+    return (int)strlen(str) == view.len && memcmp(view.ptr, str, view.len) == 0;
+}
+
+// Leading decimal number of a token, like atof (0 when there is none)
+static float parse_duration(StrView token) {
+    const char* p = token.ptr;
+    const char* end = p + token.len;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+
+    // All digits in one integer and a single division, so the result is correctly rounded
+    long long digits = 0;
+    double scale = 1;
+    int count = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        if (count++ < 18) digits = digits * 10 + (*p - '0');
+        else scale /= 10;
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++) {
+            if (count++ < 18) {
+                digits = digits * 10 + (*p - '0');
+                scale *= 10;
+            }
+        }
+    }
+    double value = digits / scale;
+    return (float)(negative ? -value : value);
+}
+
+// FNV-1a hash of a member name
+static unsigned int hash_name(StrView name) {
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < name.len; i++) {
+        hash = (hash ^ (unsigned char)name.ptr[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Slot of a name in member_slots, either holding its id or the empty slot where it belongs
+static int find_member_slot(StrView name) {
+    int mask = member_slot_count - 1;
+    int slot = hash_name(name) & mask;
+    while (member_slots[slot] && !view_equals(name, members[member_slots[slot] - 1].name)) {
+        slot = (slot + 1) & mask; // linear probing
+    }
+    return slot;
+}
+
+// Register a member and return its id (-1 if the name is invalid or already registered)
+static int add_member(StrView name) {
+    if (name.len == 0 || name.len >= MAX_STRING_LENGTH) return -1;
+
+    // Keep the table at most half full
+    if ((member_count + 1) * 2 > member_slot_count) {
+        int slot_count = member_slot_count ? member_slot_count * 2 : 64;
+        int* slots = calloc(slot_count, sizeof(int));
+        if (!slots) {
+            fprintf(stderr, "Failed to allocate memory.\n");
+            exit(1);
+        }
+        free(member_slots);
+        member_slots = slots;
+        member_slot_count = slot_count;
+        for (int id = 0; id < member_count; id++) {
+            StrView existing = {members[id].name, (int)strlen(members[id].name)};
+            member_slots[find_member_slot(existing)] = id + 1;
+        }
+    }
+
+    int slot = find_member_slot(name);
+    if (member_slots[slot]) return -1;
+
+    if (member_count == member_capacity) {
+        member_capacity = member_capacity ? member_capacity * 2 : 64;
+        members = realloc(members, member_capacity * sizeof(Member));
+        if (!members) {
+            fprintf(stderr, "Failed to allocate memory.\n");
+            exit(1);
+        }
+    }
+    memcpy(members[member_count].name, name.ptr, name.len);
+    members[member_count].name[name.len] = '\0';
+    member_slots[slot] = ++member_count;
+    return member_count - 1;
+}
+
+// Load the member registry from a file with one name per line, ids follow the file order.
+// Falls back to the default members when the file does not exist.
+static void load_members(const char* filename) {
+    FILE* file = fopen(filename, "r");
+    if (!file) {
+        for (size_t i = 0; i < sizeof(default_members) / sizeof(default_members[0]); i++) {
+            StrView name = {default_members[i], (int)strlen(default_members[i])};
+            add_member(name);
+        }
+        return;
+    }
+
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        const char* cur = line;
+        const char* end = line + strcspn(line, "\r\n");
+        StrView name;
+        if (!next_token(&cur, end, &name)) continue;
+        if (add_member(name) < 0) {
+            fprintf(stderr, "Error: Invalid or duplicate member %.*s in %s\n", name.len, name.ptr, filename);
+        }
+    }
+    fclose(file);
+}
+
+// Member id of a member name with an optional leading dash (-1 if unknown)
+static int get_member(StrView name) {
+    if (name.len > 0 && name.ptr[0] == '-') {
+        name.ptr++;
+        name.len--;
+    }
+    if (member_count == 0) return -1;
+    int id = member_slots[find_member_slot(name)];
+    return id - 1;
+}
+
+// Commands understood by the main loop
+enum {
+    CMD_UNKNOWN,
+    CMD_BOOKING,
+    CMD_PRINT_BOOKINGS,
+    CMD_ADD_BATCH,
+    CMD_PRINT_MEMORY,
+    CMD_SET_FORMAT,
+    CMD_STATS,
+    CMD_CANCEL_BOOKING,
+    CMD_MODIFY_BOOKING,
+    CMD_END_PROGRAM
+};
+
+typedef struct Command {
+    const char* name;
+    int command;            // CMD_*
+    unsigned char type;     // TYPE_* added by a booking command
+} Command;
+
+// Keywords, the entries of commands[]
+enum {
+    KW_ADD_PARKING,
+    KW_ADD_RESERVATION,
+    KW_BOOK_ESSENTIALS,
+    KW_ADD_EVENT,
+    KW_PRINT_BOOKINGS,
+    KW_ADD_BATCH,
+    KW_PRINT_MEMORY,
+    KW_SET_FORMAT,
+    KW_STATS,
+    KW_CANCEL_BOOKING,
+    KW_MODIFY_BOOKING,
+    KW_END_PROGRAM
+};
+
+static const Command commands[] = {
+    [KW_ADD_PARKING] = {"addParking", CMD_BOOKING, TYPE_PARKING},
+    [KW_ADD_RESERVATION] = {"addReservation", CMD_BOOKING, TYPE_RESERVATION},
+    [KW_BOOK_ESSENTIALS] = {"bookEssentials", CMD_BOOKING, TYPE_ESSENTIALS},
+    [KW_ADD_EVENT] = {"addEvent", CMD_BOOKING, TYPE_EVENT},
+    [KW_PRINT_BOOKINGS] = {"printBookings", CMD_PRINT_BOOKINGS, 0},
+    [KW_ADD_BATCH] = {"addBatch", CMD_ADD_BATCH, 0},
+    [KW_PRINT_MEMORY] = {"printMemory", CMD_PRINT_MEMORY, 0},
+    [KW_SET_FORMAT] = {"setFormat", CMD_SET_FORMAT, 0},
+    [KW_STATS] = {"stats", CMD_STATS, 0},
+    [KW_CANCEL_BOOKING] = {"cancelBooking", CMD_CANCEL_BOOKING, 0},
+    [KW_MODIFY_BOOKING] = {"modifyBooking", CMD_MODIFY_BOOKING, 0},
+    [KW_END_PROGRAM] = {"endProgram", CMD_END_PROGRAM, 0}
+};
+
+// Switch key of a keyword: its length with its first and last letters, which tell all keywords apart
+#define KEYWORD_KEY(len, first, last) ((len) << 16 | (unsigned char)(first) << 8 | (unsigned char)(last))
+
+// Command entry of a keyword (NULL if unknown). The key picks the only keyword it can be,
+// one compare confirms it.
+static const Command* find_command(StrView keyword) {
+    int k;
+    switch (KEYWORD_KEY(keyword.len, keyword.ptr[0], keyword.ptr[keyword.len - 1])) {
+    case KEYWORD_KEY(10, 'a', 'g'): k = KW_ADD_PARKING; break;
+    case KEYWORD_KEY(14, 'a', 'n'): k = KW_ADD_RESERVATION; break;
+    case KEYWORD_KEY(14, 'b', 's'): k = KW_BOOK_ESSENTIALS; break;
+    case KEYWORD_KEY(8, 'a', 't'): k = KW_ADD_EVENT; break;
+    case KEYWORD_KEY(13, 'p', 's'): k = KW_PRINT_BOOKINGS; break;
+    case KEYWORD_KEY(8, 'a', 'h'): k = KW_ADD_BATCH; break;
+    case KEYWORD_KEY(11, 'p', 'y'): k = KW_PRINT_MEMORY; break;
+    case KEYWORD_KEY(9, 's', 't'): k = KW_SET_FORMAT; break;
+    case KEYWORD_KEY(5, 's', 's'): k = KW_STATS; break;
+    case KEYWORD_KEY(13, 'c', 'g'): k = KW_CANCEL_BOOKING; break;
+    case KEYWORD_KEY(13, 'm', 'g'): k = KW_MODIFY_BOOKING; break;
+    case KEYWORD_KEY(10, 'e', 'm'): k = KW_END_PROGRAM; break;
+    default: return NULL;
+    }
+    return view_equals(keyword, commands[k].name) ? &commands[k] : NULL;
+}
+
+// Parse a booking command in [line, end):
+// <command> -<member> YYYY-MM-DD hh:mm <hours> [essential ...];
+// Only reads the line, so it can run on any thread.
+static void parse_booking(const char* line, const char* end, BookingRequest* req) {
+    StrView keyword, member = {NULL, 0}, date = {NULL, 0}, time = {NULL, 0}, duration = {NULL, 0}, token;
+    const char* cur = line;
+
+    memset(req, 0, sizeof(BookingRequest));
+    req->error = PARSE_NOT_BOOKING;
+    if (!next_token(&cur, end, &keyword)) return;
+    const Command* command = find_command(keyword);
+    if (!command || command->command != CMD_BOOKING) return;
+    req->type = command->type;
+
+    next_token(&cur, end, &member);
+    next_token(&cur, end, &date);
+    next_token(&cur, end, &time);
+    next_token(&cur, end, &duration);
+
+    for (int count = 0; count < MAX_ESSENTIALS && next_token(&cur, end, &token); count++) {
+        int res = get_essential_id(token.ptr, token.len);
+        req->essentials |= 1 << (res < 0 ? RES_UNKNOWN : res);
+    }
+
+    req->member = get_member(member);
+    req->duration = parse_duration(duration);
+    if (req->member < 0) req->error = PARSE_BAD_MEMBER;
+    else if (!parse_datetime(date.ptr, date.len, time.ptr, time.len, &req->start)) req->error = PARSE_BAD_DATETIME;
+    else if (req->duration <= 0) req->error = PARSE_ZERO_DURATION;
+    else req->error = PARSE_OK;
+}
+
+// Report the outcome of a parsed booking command and store the booking
+static void submit_booking(const BookingRequest* req) {
+    switch (req->error) {
+        case PARSE_NOT_BOOKING:
+            return;
+        case PARSE_OK: {
+            long long started = monotonic_ns();
+            create_booking(req);
+            record_stage(&stage_stats[STAGE_CREATE_BOOKING], monotonic_ns() - started);
+            printf("-> [Pending]");
+            return;
+        }
+        case PARSE_BAD_MEMBER:
+            printf("Error: Invalid member name\n");
+            break;
+        case PARSE_BAD_DATETIME:
+            printf(req->type == TYPE_PARKING ? "Error: Invalid date/time format\n" : "Invalid date/time format\n");
+            break;
+        case PARSE_ZERO_DURATION:
+            printf("Error: Booking duration can't be 0, must be atleast 1 hour\n");
+            printf("-> [Pending]");
+            break;
+    }
+    invalid_command_count++;
+}
+
+// Live bookings by member and start time, so cancelBooking and modifyBooking find a booking
+// without a scan. Open addressing on the key; each key heads a chain of booking indices in
+// index order, so the head is the first booking. Built on first use and extended with the
+// bookings stored since (parent only).
+typedef struct LookupSlot {
+    int member;                 // -1 -> empty slot
+    int start;
+    int head;                   // booking index + 1 of the chain, 0 once the chain is empty
+    int tail;                   // booking index + 1 of the last booking in the chain
+} LookupSlot;
+
+static LookupSlot* lookup_slots = NULL;
+static int lookup_capacity = 0;         // power of two
+static int lookup_used = 0;             // slots holding a key
+static int* lookup_next = NULL;         // next booking index + 1 in the chain, by booking
+static int lookup_next_capacity = 0;
+static int lookup_count = 0;            // bookings added to the lookup
+
+static unsigned int hash_lookup(int member, int start) {
+    unsigned int h = (unsigned int)member * 0x9E3779B1u ^ (unsigned int)start;
+    h ^= h >> 16;
+    h *= 0x45d9f3bu;
+    h ^= h >> 16;
+    return h;
+}
+
+// Slot of the key, either holding it or the empty slot where it belongs
+static int find_lookup_slot(int member, int start) {
+    unsigned int mask = lookup_capacity - 1;
+    unsigned int h = hash_lookup(member, start) & mask;
+    while (lookup_slots[h].member >= 0 &&
+           (lookup_slots[h].member != member || lookup_slots[h].start != start)) {
+        h = (h + 1) & mask;
+    }
+    return h;
+}
+
+static void grow_lookup(void) {
+    int new_capacity = lookup_capacity ? lookup_capacity * 2 : 1024;
+    LookupSlot* old = lookup_slots;
+    int old_capacity = lookup_capacity;
+    lookup_slots = malloc(new_capacity * sizeof(LookupSlot));
+    if (!lookup_slots) {
+        fprintf(stderr, "Failed to allocate memory.\n");
+        exit(1);
+    }
+    for (int h = 0; h < new_capacity; h++) lookup_slots[h].member = -1;
+    lookup_capacity = new_capacity;
+    lookup_used = 0;
+    for (int h = 0; h < old_capacity; h++) {
+        if (old[h].member < 0 || old[h].head == 0) continue; // drop the keys without bookings
+        lookup_slots[find_lookup_slot(old[h].member, old[h].start)] = old[h];
+        lookup_used++;
+    }
+    free(old);
+}
+
+static void lookup_add(int i) {
+    if ((lookup_used + 1) * 2 > lookup_capacity) grow_lookup();
+    int member = BOOKING_AT(&allBookings, member, i), start = BOOKING_AT(&allBookings, start, i);
+    LookupSlot* slot = &lookup_slots[find_lookup_slot(member, start)];
+    if (slot->member < 0) {
+        slot->member = member;
+        slot->start = start;
+        slot->head = slot->tail = 0;
+        lookup_used++;
+    }
+
+    // New bookings go last, a moved one back into its place
+    int* link = slot->tail && slot->tail < i + 1 ? &lookup_next[slot->tail - 1] : &slot->head;
+    while (*link && *link < i + 1) link = &lookup_next[*link - 1];
+    lookup_next[i] = *link;
+    *link = i + 1;
+    if (lookup_next[i] == 0) slot->tail = i + 1;
+}
+
+static void lookup_remove(int i) {
+    int member = BOOKING_AT(&allBookings, member, i), start = BOOKING_AT(&allBookings, start, i);
+    LookupSlot* slot = &lookup_slots[find_lookup_slot(member, start)];
+    int previous = 0;
+    for (int* link = &slot->head; *link; previous = *link, link = &lookup_next[*link - 1]) {
+        if (*link == i + 1) {
+            *link = lookup_next[i];
+            if (slot->tail == i + 1) slot->tail = previous;
+            return;
+        }
+    }
+}
+
+// Add the bookings stored since the last call
+static void sync_lookup(void) {
+    int count = allBookings.booking_count;
+    if (count > lookup_next_capacity) {
+        int new_capacity = lookup_next_capacity ? lookup_next_capacity : 1024;
+        while (new_capacity < count) new_capacity *= 2;
+        int* next = realloc(lookup_next, new_capacity * sizeof(int));
+        if (!next) {
+            fprintf(stderr, "Failed to allocate memory.\n");
+            exit(1);
+        }
+        lookup_next = next;
+        lookup_next_capacity = new_capacity;
+    }
+    for (; lookup_count < count; lookup_count++) {
+        if (!BOOKING_AT(&allBookings, cancelled, lookup_count)) lookup_add(lookup_count);
+    }
+}
+
+// First stored live booking of the member starting at the given time (-1 if none)
+static int find_booking(int member, int start) {
+    sync_lookup();
+    return lookup_slots[find_lookup_slot(member, start)].head - 1;
+}
+
+// Store changes of cancelBooking and modifyBooking, also used by the journal replay
+static void cancel_stored_booking(int i) {
+    if (i < lookup_count) lookup_remove(i);
+    BOOKING_AT(&allBookings, cancelled, i) = 1;
+}
+
+static void move_stored_booking(int i, int start, float duration) {
+    if (i < lookup_count) lookup_remove(i);
+    set_booking_time(i, start, duration);
+    if (i < lookup_count) lookup_add(i);
+}
+
+// cancelBooking -member YYYY-MM-DD hh:mm;
+// modifyBooking -member YYYY-MM-DD hh:mm YYYY-MM-DD hh:mm duration;
+// Change the first live booking of the member at the given start in the store, describe
+// the change in update and return its index, or print the error and return -1.
+static int change_booking(int command, const char* cur, const char* end, BookingUpdate* update) {
+    StrView member = {NULL, 0}, date = {NULL, 0}, time = {NULL, 0};
+    StrView new_date = {NULL, 0}, new_time = {NULL, 0}, duration = {NULL, 0};
+    next_token(&cur, end, &member);
+    next_token(&cur, end, &date);
+    next_token(&cur, end, &time);
+    if (command == CMD_MODIFY_BOOKING) {
+        next_token(&cur, end, &new_date);
+        next_token(&cur, end, &new_time);
+        next_token(&cur, end, &duration);
+    }
+
+    int id = get_member(member);
+    int start, new_start = 0;
+    if (id < 0) {
+        printf("Error: Invalid member name\n");
+        return -1;
+    }
+    if (!parse_datetime(date.ptr, date.len, time.ptr, time.len, &start) ||
+        (command == CMD_MODIFY_BOOKING && !parse_datetime(new_date.ptr, new_date.len, new_time.ptr, new_time.len, &new_start))) {
+        printf("Error: Invalid date/time format\n");
+        return -1;
+    }
+    float hours = command == CMD_MODIFY_BOOKING ? parse_duration(duration) : 0;
+    if (command == CMD_MODIFY_BOOKING && hours <= 0) {
+        printf("Error: Booking duration can't be 0, must be atleast 1 hour\n");
+        return -1;
+    }
+
+    int booking = find_booking(id, start);
+    if (booking < 0) {
+        printf("Error: No booking of %s at %.*s %.*s\n", members[id].name, date.len, date.ptr, time.len, time.ptr);
+        return -1;
+    }
+    update->booking = booking;
+    update->old_start = BOOKING_AT(&allBookings, start, booking);
+    update->old_end = BOOKING_AT(&allBookings, end, booking);
+    if (command == CMD_CANCEL_BOOKING) {
+        cancel_stored_booking(booking);
+        journal_booking(JOURNAL_CANCEL, booking);
+        printf("-> [Cancelled]");
+    } else {
+        move_stored_booking(booking, new_start, hours);
+        journal_booking(JOURNAL_MODIFY, booking);
+        printf("-> [Modified]");
+    }
+    update->new_start = BOOKING_AT(&allBookings, start, booking);
+    update->new_end = BOOKING_AT(&allBookings, end, booking);
+    update->cancelled = BOOKING_AT(&allBookings, cancelled, booking);
+    return booking;
+}
+
+// Part of a batch file parsed by one thread
+typedef struct ParseChunk {
+    const char* begin;
+    const char* end;            // just after a newline, or the end of the file
+    BookingRequest* requests;   // one per line, in file order
+    long line_count;
+    long capacity;
+    StageStats parse_stats;     // merged into stage_stats after the join
+} ParseChunk;
+
+static void* parse_chunk(void* arg) {
+    ParseChunk* chunk = arg;
+    for (const char* line = chunk->begin; line < chunk->end; chunk->line_count++) {
+        const char* eol = memchr(line, '\n', chunk->end - line);
+        if (!eol) eol = chunk->end;
+
+        if (chunk->line_count == chunk->capacity) {
+            chunk->capacity = chunk->capacity ? chunk->capacity * 2 : 1024;
+            chunk->requests = realloc(chunk->requests, chunk->capacity * sizeof(BookingRequest));
+            if (!chunk->requests) {
+                fprintf(stderr, "Failed to allocate memory.\n");
+                exit(1);
+            }
+        }
+        long long started = monotonic_ns();
+        parse_booking(line, eol, &chunk->requests[chunk->line_count]);
+        record_stage(&chunk->parse_stats, monotonic_ns() - started);
+        line = eol + 1;
+    }
+    return NULL;
+}
+
+// Parse [data, data + size) on up to one thread per core, then submit the bookings in file order
+// so FCFS still sees them in arrival order. Returns the number of lines.
+static long parse_batch(const char* data, size_t size) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    long thread_count = size / PARSE_CHUNK_MIN_BYTES;
+    if (thread_count > cores) thread_count = cores;
+    if (thread_count > MAX_PARSE_THREADS) thread_count = MAX_PARSE_THREADS;
+    if (thread_count < 1) thread_count = 1;
+
+    // Split at the first newline after each even cut
+    static ParseChunk chunks[MAX_PARSE_THREADS];
+    const char* end = data + size;
+    const char* begin = data;
+    for (int t = 0; t < thread_count; t++) {
+        const char* cut = t == thread_count - 1 ? end : data + size / thread_count * (t + 1);
+        if (cut < begin) cut = begin;
+        const char* eol = cut < end ? memchr(cut, '\n', end - cut) : NULL;
+        memset(&chunks[t], 0, sizeof(ParseChunk));
+        chunks[t].begin = begin;
+        chunks[t].end = eol ? eol + 1 : end;
+        begin = chunks[t].end;
+    }
+
+    pthread_t threads[MAX_PARSE_THREADS];
+    bool started[MAX_PARSE_THREADS] = {false};
+    for (int t = 1; t < thread_count; t++) {
+        started[t] = pthread_create(&threads[t], NULL, parse_chunk, &chunks[t]) == 0;
+    }
+    parse_chunk(&chunks[0]);
+
+    long lines = 0;
+    for (int t = 0; t < thread_count; t++) {
+        if (t > 0) {
+            if (started[t]) pthread_join(threads[t], NULL);
+            else parse_chunk(&chunks[t]);
+        }
+        for (long k = 0; k < chunks[t].line_count; k++) {
+            submit_booking(&chunks[t].requests[k]);
+        }
+        lines += chunks[t].line_count;
+        merge_stage(&stage_stats[STAGE_PARSE], &chunks[t].parse_stats);
+        free(chunks[t].requests);
+    }
+    return lines;
+}
+
+// Map the batch file and parse it in place, one command per line
+void process_batch_file(const char *filename) {
+    int fd = open(filename, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        perror("Unable to open batch file");
+        if (fd >= 0) close(fd);
+        invalid_command_count++;
+        return;
+    }
+
+    long long started = monotonic_ns();
+    long lines = 0;
+    size_t size = st.st_size;
+    if (size > 0) {
+        const char* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            perror("Unable to map batch file");
+            close(fd);
+            invalid_command_count++;
+            return;
+        }
+        madvise((void*)data, size, MADV_WILLNEED);
+        lines = parse_batch(data, size);
+        munmap((void*)data, size);
+    }
+    close(fd);
+
+    long long elapsed = monotonic_ns() - started;
+    record_stage(&stage_stats[STAGE_ADD_BATCH], elapsed);
+    double seconds = elapsed / 1e9;
+    printf("\nBatch: %ld line(s) in %.3f s (%.0f lines/s)\n", lines, seconds, seconds > 0 ? lines / seconds : 0.0);
+}
+
+void command_processor(const char *cmd) {
+    BookingRequest req;
+    long long started = monotonic_ns();
+    parse_booking(cmd, cmd + strlen(cmd), &req);
+    record_stage(&stage_stats[STAGE_PARSE], monotonic_ns() - started);
+    submit_booking(&req);
+}
+
+
+/* Output Module */
+// Print each requested essential followed by its pair
+static void print_essentials(FILE* fp, unsigned char essentials) {
+    unsigned char printed = 0;
+    for (int res = 0; res < RESOURCE_TYPES; res++) {
+        if (!(essentials & (1 << res)) || (printed & (1 << res))) continue;
+        fprintf(fp, " %s", essential_name(res));
+        fprintf(fp, "\n                                         %s", essential_name(res ^ 1));
+        printed |= (1 << res) | (1 << (res ^ 1));
+    }
+    if (essentials & (1 << RES_UNKNOWN)) fprintf(fp, " %s", essential_name(RES_UNKNOWN));
+}
+
+// Print one booking line of the report
+static void print_booking_line(FILE* fp, BookingList* list, int idx) {
+    char date[11];
+    int day = day_of(BOOKING_AT(list, start, idx));
+    int minute_of_day = BOOKING_AT(list, start, idx) - day * MINUTES_PER_DAY;
+    format_date(day, date);
+
+    // Calculate end time
+    int start_hour = minute_of_day / 60, start_minute = minute_of_day % 60;
+    float duration = BOOKING_AT(list, duration, idx);
+    int end_hour = start_hour + (int)duration;
+    int end_minute = start_minute + (int)((duration - (int)duration) * 60);
+    if (end_minute >= 60) {
+        end_hour += end_minute / 60;
+        end_minute %= 60;
+    }
+
+    // Print booking details
+    fprintf(fp, "%s  %02d:%02d  %02d:%02d  %-14s", date, start_hour, start_minute, end_hour, end_minute,
+            booking_types[BOOKING_AT(list, priority, idx)]);
+
+    if (BOOKING_AT(list, essentials, idx)) {
+        print_essentials(fp, BOOKING_AT(list, essentials, idx));
+    } else {
+        fputs(" *", fp);
+    }
+    fputc('\n', fp);
+}
+
+// Print one section of bookings grouped by member, in member id order.
+// Bookings are bucketed by member first so each list is walked once.
+static void print_member_groups(FILE* fp, BookingList* list, int* indices, int count, const char* status) {
+    int* offsets = calloc(member_count + 1, sizeof(int));
+    int* grouped = malloc((count > 0 ? count : 1) * sizeof(int));
+    if (!offsets || !grouped) {
+        fprintf(stderr, "Failed to allocate memory.\n");
+        exit(1);
+    }
+
+    // Counting sort by member, stable so each member keeps the list order
+    for (int j = 0; j < count; j++) offsets[BOOKING_AT(list, member, indices[j]) + 1]++;
+    for (int m = 0; m < member_count; m++) offsets[m + 1] += offsets[m];
+    for (int j = 0; j < count; j++) grouped[offsets[BOOKING_AT(list, member, indices[j])]++] = indices[j];
+
+    int from = 0;
+    for (int m = 0; m < member_count; m++) {
+        int to = offsets[m]; // offsets[m] now marks the end of member m
+        if (to == from) continue;
+
+        fprintf(fp, "\n%s has the following %s bookings:\n", members[m].name, status);
+        fprintf(fp, "Date        Start  End    Type           Device\n");
+        fprintf(fp, "===========================================================================\n");
+        for (int j = from; j < to; j++) {
+            print_booking_line(fp, list, grouped[j]);
+        }
+        from = to;
+    }
+
+    free(grouped);
+    free(offsets);
+}
+
+// Print all bookings
+static void print_bookings(FILE* fp, BookingList* list, int* acceptList, int acceptCounter, const char *algorithms) {
+    int booking_count = list->booking_count;
+    
+    // Create tracking array for accepted bookings
+    bool* is_accepted = calloc(booking_count, sizeof(bool));
+    int* accepted = malloc((acceptCounter > 0 ? acceptCounter : 1) * sizeof(int));
+    int* rejected = malloc((booking_count > 0 ? booking_count : 1) * sizeof(int));
+    if (!is_accepted || !accepted || !rejected) {
+        fprintf(stderr, "Failed to allocate memory.\n");
+        exit(1);
+    }
+    int accepted_count = 0, rejected_count = 0;
+    for (int i = 0; i < acceptCounter; i++) {
+        if (acceptList[i] < booking_count) {
+            is_accepted[acceptList[i]] = true;
+            accepted[accepted_count++] = acceptList[i];
+        }
+    }
+    for (int j = 0; j < booking_count; j++) {
+        if (!is_accepted[j] && !BOOKING_AT(list, cancelled, j)) rejected[rejected_count++] = j;
+    }
+
+    // Print ACCEPTED bookings
+    fprintf(fp, "\n*** ACCEPTED Bookings - %s ***\n", algorithms);
+    print_member_groups(fp, list, accepted, accepted_count, "ACCEPTED");
+
+    // Print REJECTED bookings
+    fprintf(fp, "\n*** REJECTED Bookings - %s ***\n", algorithms);
+    print_member_groups(fp, list, rejected, rejected_count, "REJECTED");
+
+    free(rejected);
+    free(accepted);
+    free(is_accepted);
+    fprintf(fp, "\n- End -\n");
+    fprintf(fp, "===========================================================================\n");
+}
+
+/* Analyzer Module Functions */
+// Report labels of the resources by id, and the order the summary lists them in
+static const char* resource_labels[RESOURCE_TYPES] = {"Battery", "Cable", "Locker", "Umbrella", "Inflation", "Valet"};
+static const int summary_resources[RESOURCE_TYPES] = {RES_LOCKER, RES_BATTERY, RES_CABLE, RES_UMBRELLA,
+                                                      RES_VALET, RES_INFLATION};
+
+static int calculate_days_between(int start_day, int end_day) {
+    return end_day - start_day + 1;
+}
+
+// Summary metrics of one algorithm's schedule
+typedef struct SummaryMetrics {
+    int earliest_day;           // days since 1970-01-01
+    int latest_day;
+    int test_days;
+    int received;
+    int accepted;
+    int rejected;
+    int invalid;
+    float slot_utilization;     // percent
+    float resource_utilization[RESOURCE_TYPES]; // percent, by resource id
+} SummaryMetrics;
+
+static void compute_summary(SummaryMetrics* m, BookingList* pending_bookings, int pending_count,
+                            int* accepted_indices, int accept_count, int received_invalid_count) {
+    // Find the earliest and latest booking dates
+    m->earliest_day = day_of(BOOKING_AT(pending_bookings, start, 0));
+    m->latest_day = m->earliest_day;
+    for (int i = 1; i < pending_count; i++) {
+        int day = day_of(BOOKING_AT(pending_bookings, start, i));
+        if (day < m->earliest_day) m->earliest_day = day;
+        if (day > m->latest_day) m->latest_day = day;
+    }
+    m->test_days = calculate_days_between(m->earliest_day, m->latest_day);
+
+    // Cancelled bookings no longer count as received
+    int cancelled = 0;
+    for (int i = 0; i < pending_count; i++) cancelled += BOOKING_AT(pending_bookings, cancelled, i);
+    m->received = pending_count - cancelled;
+    m->accepted = accept_count;
+    m->rejected = m->received - accept_count;
+    m->invalid = received_invalid_count;
+
+    // Calculate Time Slot Utilization
+    int total_slots = m->test_days * 24 * sys_res.parking_slots; // Total slots = days * 24 hours * slots
+    float total_occupied_hours = 0;
+    for (int i = 0; i < accept_count; i++) {
+        int idx = accepted_indices[i];
+        total_occupied_hours += BOOKING_AT(pending_bookings, duration, idx); // Sum durations of accept bookings
+    }
+    m->slot_utilization = (total_occupied_hours / total_slots) * 100;
+
+    // Calculate Resource Utilization
+    int used[RESOURCE_TYPES] = {0};
+    for (int i = 0; i < accept_count; i++) {
+        int idx = accepted_indices[i];
+        int current_duration = BOOKING_AT(pending_bookings, duration, idx);
+
+        // Booking an essential also takes its pair
+        unsigned char essentials = with_pairs(BOOKING_AT(pending_bookings, essentials, idx));
+        for (int res = 0; res < RESOURCE_TYPES; res++) {
+            if (essentials & (1 << res)) used[res] += current_duration;
+        }
+    }
+    for (int res = 0; res < RESOURCE_TYPES; res++) {
+        m->resource_utilization[res] = (used[res] / (float)(m->test_days * 24 * resource_capacity(res))) * 100;
+    }
+}
+
+// Append the summary of one algorithm's schedule
+static void print_summary(FILE* fp, const SummaryMetrics* m, const char* algorithm) {
+    fprintf(fp, "\n*** Parking Booking Manager – Summary Report ***\n");
+
+    char earliest_date[11], latest_date[11];
+    format_date(m->earliest_day, earliest_date);
+    format_date(m->latest_day, latest_date);
+    fprintf(fp, "Test Period: %s to %s (%d days)\n", earliest_date, latest_date, m->test_days);
+
+    // Performance of the algorithm
+    fprintf(fp, "\nPerformance:\nFor %s:\n", algorithm);
+    fprintf(fp, "Total Number of Bookings Received: %d\n", m->received);
+    fprintf(fp, "Number of Bookings Assigned: %d\n", m->accepted);
+    fprintf(fp, "Number of Bookings Rejected: %d\n", m->rejected);
+    fprintf(fp, "Utilization of Time Slot: %.1f%%\n", m->slot_utilization);
+
+    fprintf(fp, "\nResource Utilization:\n");
+    for (int k = 0; k < RESOURCE_TYPES; k++) {
+        int res = summary_resources[k];
+        fprintf(fp, "%s - %.1f%%\n", resource_labels[res], m->resource_utilization[res]);
+    }
+
+    // Invalid Requests
+    fprintf(fp, "\nInvalid request(s) made: %d\n", m->invalid);
+}
+
+// Occupancy of the parking slots and essentials over the test period, measured from
+// the accepted bookings with one sweep over their start/end events
+#define OCCUPANCY_PARKING RESOURCE_TYPES // sweep category of the parking slots, after the resources
+#define OCCUPANCY_CATEGORIES (RESOURCE_TYPES + 1)
+
+typedef struct OccupancyMetrics {
+    int peak[OCCUPANCY_CATEGORIES];         // most units in use at once
+    int peak_time[OCCUPANCY_CATEGORIES];    // first minute the peak was reached
+    double hourly_parking[24];              // percent of slot-minutes in use, by hour of day
+    int hourly_rejected[24];                // rejected bookings by starting hour
+    int idle_gaps;                          // periods with no parking slot in use
+    int longest_idle;                       // minutes
+    long long total_idle;                   // minutes
+} OccupancyMetrics;
+
+static int compare_events(const void* a, const void* b) {
+    unsigned long long x = *(const unsigned long long*)a, y = *(const unsigned long long*)b;
+    return x < y ? -1 : x > y;
+}
+
+// Record an idle gap of the parking slots, clipped to the test period
+static void add_idle_gap(OccupancyMetrics* o, int from, int to, int period_start, int period_end) {
+    if (from < period_start) from = period_start;
+    if (to > period_end) to = period_end;
+    if (to <= from) return;
+    o->idle_gaps++;
+    o->total_idle += to - from;
+    if (to - from > o->longest_idle) o->longest_idle = to - from;
+}
+
+// One event per start and end of every unit the accepted bookings hold. Key: the booking's
+// date (when by_date, else 0) and minute offset from the period start, then end (0) before
+// start (1) so back-to-back bookings never overlap, then the category.
+static int occupancy_events(unsigned long long* events, BookingList* list, int* accepted_indices, int accept_count,
+                            int period_start, int first_day, bool by_date) {
+    int event_count = 0;
+    for (int k = 0; k < accept_count; k++) {
+        int idx = accepted_indices[k];
+        unsigned long long date = by_date ? (unsigned long long)(day_of(BOOKING_AT(list, start, idx)) - first_day) << 40 : 0;
+        unsigned long long start = BOOKING_AT(list, start, idx) - period_start;
+        unsigned long long end = BOOKING_AT(list, end, idx) - period_start;
+        unsigned int categories = with_pairs(BOOKING_AT(list, essentials, idx));
+        if (BOOKING_AT(list, priority, idx) != TYPE_ESSENTIALS) categories |= 1 << OCCUPANCY_PARKING;
+        for (int c = 0; c < OCCUPANCY_CATEGORIES; c++) {
+            if (!(categories & (1 << c))) continue;
+            events[event_count++] = date | end << 4 | c;
+            events[event_count++] = date | start << 4 | 1 << 3 | c;
+        }
+    }
+    qsort(events, event_count, sizeof(unsigned long long), compare_events);
+    return event_count;
+}
+
+static void compute_occupancy(OccupancyMetrics* o, BookingList* list, int pending_count,
+                              int* accepted_indices, int accept_count, const SummaryMetrics* m) {
+    memset(o, 0, sizeof(OccupancyMetrics));
+    int period_start = m->earliest_day * MINUTES_PER_DAY;
+    int period_end = (m->latest_day + 1) * MINUTES_PER_DAY;
+
+    bool* is_accepted = calloc(pending_count > 0 ? pending_count : 1, sizeof(bool));
+    unsigned long long* events = malloc((size_t)(accept_count > 0 ? accept_count : 1) * 2 * OCCUPANCY_CATEGORIES *
+                                        sizeof(unsigned long long));
+    if (!is_accepted || !events) {
+        fprintf(stderr, "Failed to allocate memory.\n");
+        exit(1);
+    }
+    for (int k = 0; k < accept_count; k++) is_accepted[accepted_indices[k]] = true;
+    int event_count = occupancy_events(events, list, accepted_indices, accept_count, period_start, m->earliest_day, false);
+
+    int in_use[OCCUPANCY_CATEGORIES] = {0};
+    long long hourly_minutes[24] = {0};
+    int last = period_start, idle_since = period_start;
+    for (int e = 0; e < event_count; e++) {
+        int time = (int)(events[e] >> 4) + period_start;
+        bool is_start = (events[e] >> 3) & 1;
+        int c = events[e] & 7;
+
+        // Slot-minutes in use since the previous event, split at the hour boundaries
+        for (int t = last; t < time && in_use[OCCUPANCY_PARKING] > 0;) {
+            int minute_of_day = t - day_of(t) * MINUTES_PER_DAY;
+            int step = 60 - minute_of_day % 60;
+            if (step > time - t) step = time - t;
+            hourly_minutes[minute_of_day / 60] += (long long)step * in_use[OCCUPANCY_PARKING];
+            t += step;
+        }
+        if (time > last) last = time;
+
+        if (is_start) {
+            if (c == OCCUPANCY_PARKING && in_use[c] == 0) add_idle_gap(o, idle_since, time, period_start, period_end);
+            in_use[c]++;
+        }
+        else if (--in_use[c] == 0 && c == OCCUPANCY_PARKING) {
+            idle_since = time;
+        }
+    }
+    if (in_use[OCCUPANCY_PARKING] == 0) add_idle_gap(o, idle_since, period_end, period_start, period_end);
+
+    // Bookings of different dates never conflict, as in the schedulers, so the peaks
+    // count the bookings of one date at a time (each date's sweep ends with all released)
+    event_count = occupancy_events(events, list, accepted_indices, accept_count, period_start, m->earliest_day, true);
+    for (int e = 0; e < event_count; e++) {
+        int time = (int)((events[e] >> 4) & ((1ULL << 36) - 1)) + period_start;
+        int c = events[e] & 7;
+        if (!((events[e] >> 3) & 1)) {
+            in_use[c]--;
+        } else if (++in_use[c] > o->peak[c]) {
+            o->peak[c] = in_use[c];
+            o->peak_time[c] = time;
+        }
+    }
+
+    double slot_minutes_per_hour = (double)m->test_days * 60 * sys_res.parking_slots;
+    for (int h = 0; h < 24; h++) {
+        o->hourly_parking[h] = hourly_minutes[h] / slot_minutes_per_hour * 100;
+    }
+    for (int i = 0; i < pending_count; i++) {
+        if (is_accepted[i] || BOOKING_AT(list, cancelled, i)) continue;
+        int start = BOOKING_AT(list, start, i);
+        o->hourly_rejected[(start - day_of(start) * MINUTES_PER_DAY) / 60]++;
+    }
+
+    free(events);
+    free(is_accepted);
+}
+
+// "YYYY-MM-DD hh:mm" of a minute timestamp
+static void format_time(int minutes, char* buf) {
+    int day = day_of(minutes);
+    int minute_of_day = minutes - day * MINUTES_PER_DAY;
+    format_date(day, buf);
+    sprintf(buf + 10, " %02d:%02d", minute_of_day / 60, minute_of_day % 60);
+}
+
+// Extended section of the summary report
+static void print_occupancy(FILE* fp, const OccupancyMetrics* o) {
+    char when[32];
+    fprintf(fp, "\nPeak Concurrent Occupancy:\n");
+    fprintf(fp, "Parking Slots - %d/%d", o->peak[OCCUPANCY_PARKING], sys_res.parking_slots);
+    if (o->peak[OCCUPANCY_PARKING]) {
+        format_time(o->peak_time[OCCUPANCY_PARKING], when);
+        fprintf(fp, " at %s", when);
+    }
+    fprintf(fp, "\n");
+    for (int k = 0; k < RESOURCE_TYPES; k++) {
+        int res = summary_resources[k];
+        fprintf(fp, "%s - %d/%d", resource_labels[res], o->peak[res], resource_capacity(res));
+        if (o->peak[res]) {
+            format_time(o->peak_time[res], when);
+            fprintf(fp, " at %s", when);
+        }
+        fprintf(fp, "\n");
+    }
+
+    fprintf(fp, "\nHourly Parking Occupancy:\n");
+    fprintf(fp, "Hour   Occupied  Rejected\n");
+    for (int h = 0; h < 24; h++) {
+        fprintf(fp, "%02d:00  %7.1f%%  %8d\n", h, o->hourly_parking[h], o->hourly_rejected[h]);
+    }
+
+    fprintf(fp, "\nIdle Gaps (no parking slot in use): %d\n", o->idle_gaps);
+    fprintf(fp, "Longest Idle Gap: %.1f hours\n", o->longest_idle / 60.0);
+    fprintf(fp, "Total Idle Time: %.1f hours\n", o->total_idle / 60.0);
+}
+
+/* Export Module Functions */
+// Report formats selected with setFormat. The text report is rendered per section
+// and appended on flush; the other formats stream one record per booking to their
+// own files through a large stdio buffer, so no copy of the schedule is built.
+enum {
+    FORMAT_TEXT,
+    FORMAT_CSV,
+    FORMAT_JSONL,
+    FORMAT_BINARY,
+    FORMAT_COUNT
+};
+
+static const char* format_names[FORMAT_COUNT] = {"text", "csv", "jsonl", "binary"};
+static const char* format_extensions[FORMAT_COUNT] = {"txt", "csv", "jsonl", "bin"};
+static const char* export_types[PRIORITY_LEVELS] = {"Essentials", "Parking", "Reservation", "Event"};
+
+#define BOOKING_ACCEPTED 1
+#define BOOKING_REJECTED 2
+
+// Binary formats, host byte order. A bookings file starts with BINARY_BOOKINGS_MAGIC,
+// the member count and the member names (MAX_STRING_LENGTH bytes each), then one
+// BookingRecord per booking. A summary file starts with BINARY_SUMMARY_MAGIC, then
+// one SummaryRecord per algorithm.
+#define BINARY_BOOKINGS_MAGIC "SPMSBKG1"
+#define BINARY_SUMMARY_MAGIC "SPMSSUM1"
+
+typedef struct BookingRecord {
+    int booking;                // index in arrival order
+    int member;                 // member id
+    int start;                  // minutes since 1970-01-01 00:00
+    int end;
+    float duration;             // hours
+    unsigned char type;         // TYPE_*
+    unsigned char essentials;   // reserved essentials (pairs included), bit = resource id or RES_UNKNOWN
+    unsigned char status;       // BOOKING_ACCEPTED / BOOKING_REJECTED
+    unsigned char algorithm;    // 0 fcfs, 1 prio, 2 opti
+} BookingRecord;
+
+typedef struct SummaryRecord {
+    int algorithm;
+    SummaryMetrics metrics;
+} SummaryRecord;
+
+// Open (truncate) an export file the first time it is used in this process
+static FILE* open_export(FILE** files, int format, const char* kind, bool* created) {
+    *created = false;
+    if (files[format]) return files[format];
+
+    char filename[64];
+    snprintf(filename, sizeof(filename), EXPORT_PREFIX "%s.%s", kind, format_extensions[format]);
+    FILE* fp = fopen(filename, format == FORMAT_BINARY ? "wb" : "w");
+    if (!fp) {
+        perror("Failed to open export file");
+        return NULL;
+    }
+    char* buffer = malloc(EXPORT_BUFFER_SIZE); // lives as long as the file
+    if (buffer) setvbuf(fp, buffer, _IOFBF, EXPORT_BUFFER_SIZE);
+    files[format] = fp;
+    *created = true;
+    return fp;
+}
+
+static void flush_exports(FILE** files) {
+    for (int f = 0; f < FORMAT_COUNT; f++) {
+        if (files[f]) fflush(files[f]);
+    }
+}
+
+// Write a member name as a CSV field, quoted when needed
+static void write_csv_name(FILE* fp, const char* name) {
+    if (!strpbrk(name, ",\"")) {
+        fputs(name, fp);
         return;
     }
+    fputc('"', fp);
+    for (const char* p = name; *p; p++) {
+        if (*p == '"') fputc('"', fp);
+        fputc(*p, fp);
+    }
+    fputc('"', fp);
+}
+
+// Write a member name as a JSON string
+static void write_json_name(FILE* fp, const char* name) {
+    fputc('"', fp);
+    for (const char* p = name; *p; p++) {
+        if (*p == '"' || *p == '\\') fputc('\\', fp);
+        if ((unsigned char)*p < 0x20) fprintf(fp, "\\u%04x", *p);
+        else fputc(*p, fp);
+    }
+    fputc('"', fp);
+}
+
+// "YYYY-MM-DDThh:mm" of a minute timestamp
+static void format_minute(int minutes, char* buf) {
+    int day = day_of(minutes);
+    int minute_of_day = minutes - day * MINUTES_PER_DAY;
+    format_date(day, buf);
+    sprintf(buf + 10, "T%02d:%02d", minute_of_day / 60, minute_of_day % 60);
+}
+
+static void export_booking(FILE* fp, int format, BookingList* list, int idx, const char* algorithm,
+                           int section, int status) {
+    unsigned char essentials = with_pairs(BOOKING_AT(list, essentials, idx));
+
+    if (format == FORMAT_BINARY) {
+        BookingRecord record = {idx, BOOKING_AT(list, member, idx), BOOKING_AT(list, start, idx),
+                                BOOKING_AT(list, end, idx), BOOKING_AT(list, duration, idx),
+                                BOOKING_AT(list, priority, idx), essentials, (unsigned char)status,
+                                (unsigned char)section};
+        fwrite(&record, sizeof(record), 1, fp);
+        return;
+    }
+
+    char start[32], end[32];
+    format_minute(BOOKING_AT(list, start, idx), start);
+    format_minute(BOOKING_AT(list, end, idx), end);
+    const char* member = members[BOOKING_AT(list, member, idx)].name;
+    const char* type = export_types[BOOKING_AT(list, priority, idx)];
+    const char* status_name = status == BOOKING_ACCEPTED ? "accepted" : "rejected";
+
+    if (format == FORMAT_CSV) {
+        fprintf(fp, "%s,%d,", algorithm, idx);
+        write_csv_name(fp, member);
+        fprintf(fp, ",%s,%s,%s,%g,", type, start, end, BOOKING_AT(list, duration, idx));
+        const char* separator = "";
+        for (int res = 0; res <= RES_UNKNOWN; res++) {
+            if (!(essentials & (1 << res))) continue;
+            fprintf(fp, "%s%s", separator, essential_name(res));
+            separator = "|";
+        }
+        fprintf(fp, ",%s\n", status_name);
+    }
+    else {
+        fprintf(fp, "{\"algorithm\":\"%s\",\"booking\":%d,\"member\":", algorithm, idx);
+        write_json_name(fp, member);
+        fprintf(fp, ",\"type\":\"%s\",\"start\":\"%s\",\"end\":\"%s\",\"duration\":%g,\"essentials\":[",
+                type, start, end, BOOKING_AT(list, duration, idx));
+        const char* separator = "";
+        for (int res = 0; res <= RES_UNKNOWN; res++) {
+            if (!(essentials & (1 << res))) continue;
+            fprintf(fp, "%s\"%s\"", separator, essential_name(res));
+            separator = ",";
+        }
+        fprintf(fp, "],\"status\":\"%s\"}\n", status_name);
+    }
+}
+
+// Stream every booking of one algorithm's schedule, accepted ones first in acceptance order,
+// then the rejected ones in arrival order
+static void export_bookings(FILE** files, int format, BookingList* list, int* acceptList, int acceptCounter,
+                            const char* algorithm, int section) {
+    bool created;
+    FILE* fp = open_export(files, format, "bookings", &created);
+    if (!fp) return;
+    if (created) {
+        if (format == FORMAT_CSV) {
+            fputs("algorithm,booking,member,type,start,end,duration,essentials,status\n", fp);
+        }
+        else if (format == FORMAT_BINARY) {
+            char name[MAX_STRING_LENGTH];
+            fwrite(BINARY_BOOKINGS_MAGIC, 8, 1, fp);
+            fwrite(&member_count, sizeof(member_count), 1, fp);
+            for (int m = 0; m < member_count; m++) {
+                strncpy(name, members[m].name, sizeof(name));
+                fwrite(name, sizeof(name), 1, fp);
+            }
+        }
+    }
+
+    int booking_count = list->booking_count;
+    bool* is_accepted = calloc(booking_count > 0 ? booking_count : 1, sizeof(bool));
+    if (!is_accepted) {
+        fprintf(stderr, "Failed to allocate memory.\n");
+        exit(1);
+    }
+    for (int i = 0; i < acceptCounter; i++) {
+        if (acceptList[i] >= booking_count) continue;
+        is_accepted[acceptList[i]] = true;
+        export_booking(fp, format, list, acceptList[i], algorithm, section, BOOKING_ACCEPTED);
+    }
+    for (int j = 0; j < booking_count; j++) {
+        if (!is_accepted[j] && !BOOKING_AT(list, cancelled, j)) {
+            export_booking(fp, format, list, j, algorithm, section, BOOKING_REJECTED);
+        }
+    }
+    free(is_accepted);
+}
+
+static void export_summary(FILE** files, int format, const SummaryMetrics* m, const char* algorithm, int section) {
+    bool created;
+    FILE* fp = open_export(files, format, "summary", &created);
+    if (!fp) return;
+
+    char earliest_date[11], latest_date[11];
+    format_date(m->earliest_day, earliest_date);
+    format_date(m->latest_day, latest_date);
+
+    if (format == FORMAT_BINARY) {
+        if (created) fwrite(BINARY_SUMMARY_MAGIC, 8, 1, fp);
+        SummaryRecord record = {section, *m};
+        fwrite(&record, sizeof(record), 1, fp);
+    }
+    else if (format == FORMAT_CSV) {
+        if (created) {
+            fputs("algorithm,period_start,period_end,days,received,accepted,rejected,invalid,slot_utilization", fp);
+            for (int res = 0; res < RESOURCE_TYPES; res++) fprintf(fp, ",%s", essential_name(res));
+            fputc('\n', fp);
+        }
+        fprintf(fp, "%s,%s,%s,%d,%d,%d,%d,%d,%.4f", algorithm, earliest_date, latest_date, m->test_days,
+                m->received, m->accepted, m->rejected, m->invalid, m->slot_utilization);
+        for (int res = 0; res < RESOURCE_TYPES; res++) fprintf(fp, ",%.4f", m->resource_utilization[res]);
+        fputc('\n', fp);
+    }
+    else {
+        fprintf(fp, "{\"algorithm\":\"%s\",\"period_start\":\"%s\",\"period_end\":\"%s\",\"days\":%d,"
+                    "\"received\":%d,\"accepted\":%d,\"rejected\":%d,\"invalid\":%d,\"slot_utilization\":%.4f,"
+                    "\"resource_utilization\":{",
+                algorithm, earliest_date, latest_date, m->test_days, m->received, m->accepted, m->rejected,
+                m->invalid, m->slot_utilization);
+        for (int res = 0; res < RESOURCE_TYPES; res++) {
+            fprintf(fp, "%s\"%s\":%.4f", res ? "," : "", essential_name(res), m->resource_utilization[res]);
+        }
+        fputs("}}\n", fp);
+    }
+}
+
+/* Pipe Helpers */
+// Read a whole buffer (a pipe may deliver a large transfer in several parts)
+static bool read_all(int fd, void* buf, size_t len) {
+    char* p = buf;
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+// Print the memory held by each chunk of the booking list
+static void print_memory_usage(BookingList* list) {
+    size_t chunk_bytes = list->shared_fd >= 0 ? chunk_stride() : sizeof(BookingChunk);
+    size_t table_bytes = list->chunk_capacity * (sizeof(BookingChunk*) + sizeof(ScheduleChunk*));
+    size_t total = table_bytes;
+    printf("Booking store: %d booking(s) in %d %s chunk(s) of %d\n", list->booking_count, list->chunk_count,
+           list->shared_fd >= 0 ? "shared" : "private", BOOKING_CHUNK_SIZE);
+    for (int c = 0; c < list->chunk_count; c++) {
+        printf("Chunk %d: %d/%d bookings, %zu bytes\n", c, chunk_length(list, c), BOOKING_CHUNK_SIZE, chunk_bytes);
+        total += chunk_bytes;
+    }
+    printf("Total: %zu bytes (chunk tables %zu bytes)\n", total, table_bytes);
+}
+
+/* Module Protocol */
+// Every message between the parent and a child module is one frame: a header
+// with the message type and payload length, then the payload. A request is
+// answered by exactly one reply, so there is no per-field acknowledgement.
+enum {
+    MSG_SCHEDULE,   // parent -> Scheduler: ModuleRequest, answered by MSG_RESULT
+    MSG_RESULT,     // Scheduler -> parent: ModuleRequest (work time) + accepted booking indices
+    MSG_REPORT,     // parent -> Output: ModuleRequest + accepted indices, answered by MSG_DONE once rendered
+    MSG_ANALYZE,    // parent -> Analyzer: ModuleRequest + accepted indices, answered by MSG_DONE once rendered
+    MSG_FLUSH,      // parent -> Output/Analyzer: append the rendered sections, answered by MSG_DONE
+    MSG_DONE,       // child -> parent: ModuleRequest (work time), request handled
+    MSG_STATS,      // parent -> child: no payload; child -> parent: its StageStats array
+    MSG_UPDATE,     // parent -> Scheduler: BookingUpdate of a cancelled or moved booking, not answered
+    MSG_EXIT        // parent -> child: terminate
+};
+
+typedef struct MessageHeader {
+    int type;
+    int length;             // payload bytes following the header
+} MessageHeader;
+
+// Fixed part of a request, the accepted indices follow it in the same frame
+typedef struct ModuleRequest {
+    char algorithm[8];
+    int section;            // position of the algorithm's section in the report
+    int booking_count;      // bookings of the shared store covered by the request
+    int invalid_count;      // invalid commands so far (Analyzer only)
+    int format;             // FORMAT_* of the report
+    long long work_ns;      // time the module spent on the request (replies only)
+} ModuleRequest;
+
+// Write all the buffers (a large frame may go out in several parts)
+static bool writev_all(int fd, struct iovec* iov, int iovcnt) {
+    while (iovcnt > 0) {
+        ssize_t n = writev(fd, iov, iovcnt);
+        if (n <= 0) return false;
+        while (iovcnt > 0 && (size_t)n >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char*)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+    return true;
+}
+
+// Send one frame: header, optional request and optional indices in a single writev
+static bool send_message(int fd, int type, const ModuleRequest* req, const int* indices, int index_count) {
+    MessageHeader header = {type, (int)((req ? sizeof(ModuleRequest) : 0) + index_count * sizeof(int))};
+    struct iovec iov[3];
+    int iovcnt = 0;
+    iov[iovcnt++] = (struct iovec){&header, sizeof(header)};
+    if (req) iov[iovcnt++] = (struct iovec){(void*)req, sizeof(ModuleRequest)};
+    if (index_count > 0) iov[iovcnt++] = (struct iovec){(void*)indices, index_count * sizeof(int)};
+    long long started = monotonic_ns();
+    bool sent = writev_all(fd, iov, iovcnt);
+    record_stage(&stage_stats[STAGE_IPC], monotonic_ns() - started);
+    return sent;
+}
+
+// Receive one frame. Requests fill req, the indices are returned in a malloc'ed
+// array (NULL when the frame carries none)
+static bool recv_message(int fd, int* type, ModuleRequest* req, int** indices, int* index_count) {
+    MessageHeader header;
+    *indices = NULL;
+    *index_count = 0;
+    if (!read_all(fd, &header, sizeof(header))) return false;
+    *type = header.type;
+    long long started = monotonic_ns(); // the transfer, not the wait for the header
+
+    size_t length = header.length;
+    if (header.type == MSG_SCHEDULE || header.type == MSG_REPORT || header.type == MSG_ANALYZE ||
+        header.type == MSG_RESULT || header.type == MSG_DONE) {
+        if (length < sizeof(ModuleRequest) || !read_all(fd, req, sizeof(ModuleRequest))) return false;
+        length -= sizeof(ModuleRequest);
+    }
+    if (length > 0) {
+        *indices = malloc(length);
+        if (!*indices) {
+            fprintf(stderr, "Failed to allocate memory.\n");
+            exit(1);
+        }
+        if (!read_all(fd, *indices, length)) {
+            free(*indices);
+            *indices = NULL;
+            return false;
+        }
+        *index_count = length / sizeof(int);
+    }
+    record_stage(&stage_stats[STAGE_IPC], monotonic_ns() - started);
+    return true;
+}
+
+// Answer MSG_STATS with the counters of this process
+static void send_stats(int fd) {
+    send_message(fd, MSG_STATS, NULL, (const int*)stage_stats, sizeof(stage_stats) / (sizeof(int)));
+}
+
+// Report text of one algorithm. Output and Analyzer render a section as soon as
+// its result arrives and append all sections in order on MSG_FLUSH, so the
+// report layout does not depend on which scheduler finished first.
+typedef struct ReportSection {
+    char* text;
+    size_t length;
+} ReportSection;
+
+static FILE* open_section(ReportSection* section) {
+    free(section->text);
+    section->text = NULL;
+    section->length = 0;
+    FILE* fp = open_memstream(&section->text, &section->length);
+    if (!fp) {
+        fprintf(stderr, "Failed to allocate memory.\n");
+        exit(1);
+    }
+    return fp;
+}
+
+// Append the rendered sections to the report with a single writev.
+// The report file is opened once per process and kept open.
+static void flush_sections(ReportSection* sections, int count) {
+    static int report_fd = -1;
+    if (report_fd < 0) {
+        report_fd = open(REPORT_FILE, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+        if (report_fd < 0) perror("Failed to open report file");
+    }
+
+    struct iovec iov[ALGORITHM_COUNT];
+    int iovcnt = 0;
+    for (int k = 0; k < count && iovcnt < ALGORITHM_COUNT; k++) {
+        if (sections[k].text && sections[k].length) {
+            iov[iovcnt++] = (struct iovec){sections[k].text, sections[k].length};
+        }
+    }
+    if (report_fd >= 0 && iovcnt > 0 && !writev_all(report_fd, iov, iovcnt)) {
+        perror("Failed to write report file");
+    }
+
+    for (int k = 0; k < count; k++) {
+        free(sections[k].text);
+        sections[k].text = NULL;
+        sections[k].length = 0;
+    }
+}
+
+// Wait for the MSG_DONE reply of a child, adding the time it worked on the request
+static bool recv_done(int fd, long long* work_ns) {
+    ModuleRequest reply;
+    int type, count;
+    int* indices;
+    if (!recv_message(fd, &type, &reply, &indices, &count)) return false;
+    free(indices);
+    if (type != MSG_DONE) return false;
+    *work_ns += reply.work_ns;
+    return true;
+}
 
-    create_booking(member, date, time, duration, essentials, count, -1, "Event");
-    printf("-> [Pending]");
-   
+/* Persistence Module */
+// With -store <directory> the booking store survives a restart. Every stored booking is
+// appended to a binary journal, written and synced at the end of each command. Every
+// SNAPSHOT_INTERVAL bookings, and at exit, the store's chunks are written to a snapshot
+// and the journal starts over. Startup maps the snapshot, copies its chunks into the
+// store and replays the journal records that came after it.
+#define SNAPSHOT_MAGIC "SPMSSNP1"
+#define SNAPSHOT_INTERVAL (1 << 20)     // journaled bookings before a new snapshot
+#define JOURNAL_BUFFER_RECORDS 65536
+
+// One change of a stored booking. The member is kept by name, the registry may change between runs.
+typedef struct JournalRecord {
+    int index;                          // position in the booking store
+    int start;                          // minutes since 1970-01-01 00:00
+    float duration;                     // hours
+    unsigned char type;                 // TYPE_*
+    unsigned char essentials;           // bitmask of requested essentials
+    unsigned char op;                   // JOURNAL_*, the booking's state after the change
+    char member[MAX_STRING_LENGTH];
+} JournalRecord;
+
+// Start of the snapshot file, followed by member_count Members and the chunks
+typedef struct SnapshotHeader {
+    char magic[8];
+    int chunk_bytes;                    // sizeof(BookingChunk), another layout cannot be loaded
+    int booking_count;
+    int member_count;
+} SnapshotHeader;
+
+static char journal_path[512];
+static char snapshot_path[512];
+static int journal_fd = -1;             // -1 -> bookings are not journaled
+static JournalRecord* journal_buffer = NULL;
+static int journal_buffered = 0;
+static bool journal_dirty = false;      // written since the last sync
+static int snapshot_count = 0;          // bookings covered by the snapshot
+
+static void write_journal_buffer(void) {
+    if (journal_buffered == 0) return;
+    struct iovec iov = {journal_buffer, journal_buffered * sizeof(JournalRecord)};
+    if (!writev_all(journal_fd, &iov, 1)) perror("Failed to write journal");
+    journal_buffered = 0;
+    journal_dirty = true;
 }
 
+static void journal_booking(int op, int index) {
+    if (journal_fd < 0) return;
+    if (journal_buffered == JOURNAL_BUFFER_RECORDS) write_journal_buffer();
+    JournalRecord* rec = &journal_buffer[journal_buffered++];
+    memset(rec, 0, sizeof(JournalRecord));
+    rec->index = index;
+    rec->start = BOOKING_AT(&allBookings, start, index);
+    rec->duration = BOOKING_AT(&allBookings, duration, index);
+    rec->type = BOOKING_AT(&allBookings, priority, index);
+    rec->essentials = BOOKING_AT(&allBookings, essentials, index);
+    rec->op = op;
+    strcpy(rec->member, members[BOOKING_AT(&allBookings, member, index)].name);
+}
 
-void process_batch_file(const char *filename) {
-    FILE *file = fopen(filename, "r");
-    if (!file) {
-        perror("Unable to open batch file");
-        invalid_command_count++;
+// Write the whole store to a new snapshot, then empty the journal it replaces
+static void write_snapshot(void) {
+    char temp_path[sizeof(snapshot_path) + 4];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", snapshot_path);
+    int fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror("Failed to write snapshot");
         return;
     }
 
-    char line[256];
-    while (fgets(line, sizeof(line), file)) {
-        line[strcspn(line, "\n")] = 0; // Remove a newline
-        command_processor(line);
+    SnapshotHeader header = {SNAPSHOT_MAGIC, sizeof(BookingChunk), allBookings.booking_count, member_count};
+    struct iovec iov[2] = {{&header, sizeof(header)}, {members, member_count * sizeof(Member)}};
+    bool written = writev_all(fd, iov, 2);
+    int chunks = (allBookings.booking_count + BOOKING_CHUNK_SIZE - 1) >> BOOKING_CHUNK_SHIFT;
+    for (int c = 0; c < chunks && written; c++) {
+        struct iovec chunk = {allBookings.chunks[c], sizeof(BookingChunk)};
+        written = writev_all(fd, &chunk, 1);
+    }
+    written = written && fdatasync(fd) == 0;
+    close(fd);
+    if (!written || rename(temp_path, snapshot_path) < 0) {
+        perror("Failed to write snapshot");
+        unlink(temp_path);
+        return;
     }
 
-    fclose(file);
+    // Records of the snapshotted bookings are skipped on replay, so a crash here loses nothing
+    if (ftruncate(journal_fd, 0) < 0) perror("Failed to truncate journal");
+    snapshot_count = allBookings.booking_count;
 }
 
-static Member* get_member(const char* member_name) {
-    char clean_name[MAX_STRING_LENGTH];
-    strncpy(clean_name, member_name, sizeof(clean_name)-1);
-    clean_name[sizeof(clean_name)-1] = '\0';
-   
-    // Remove the dash
-    if (clean_name[0] == '-') {
-        size_t len = strlen(clean_name);
-        memmove(clean_name, clean_name + 1, len);
-    }
-   
-    for (int i = 0; i < MAX_USERS; i++) {
-        if (strcmp(clean_name, members[i].name) == 0) {
-            return &members[i];
-        }
+// Make the bookings of the last command durable, called between commands
+static void commit_journal(void) {
+    if (journal_fd < 0) return;
+    write_journal_buffer();
+    if (journal_dirty) {
+        if (fdatasync(journal_fd) < 0) perror("Failed to sync journal");
+        journal_dirty = false;
     }
-    return NULL;
+    if (allBookings.booking_count - snapshot_count >= SNAPSHOT_INTERVAL) write_snapshot();
 }
 
-void command_processor(char *cmd) {
-    char *token = strtok(cmd, " ");
-    if (token == NULL) return;
-
-    if (strcmp(token, "addParking") == 0) {
-        char member_name[MAX_STRING_LENGTH], date[11], time[6];
-        float duration;
-        char essentials[MAX_ESSENTIALS][MAX_STRING_LENGTH];
-        int count = 0;
-       
-        token = strtok(NULL, " ");
-        if (token) strcpy(member_name, token);
-        token = strtok(NULL, " ");
-        if (token) strcpy(date, token);
-        token = strtok(NULL, " ");
-        if (token) strcpy(time, token);
-        token = strtok(NULL, " ");
-        if (token) duration = (float)atof(token);
-       
-        while ((token = strtok(NULL, " ")) != NULL && count < MAX_ESSENTIALS) {
-            if (token[strlen(token) - 1] == ';')
-                token[strlen(token) - 1] = '\0';
-            strcpy(essentials[count++], token);
-        }
-
-        Member* member = get_member(member_name);
-        if (!member) {
-            printf("Error: Invalid member name\n");
-            invalid_command_count++;
-            return;
-        }
-        add_parking(member->name, date, time, duration, essentials, count);
-    }
-    else if (strcmp(token, "addReservation") == 0) {
-        char member_name[MAX_STRING_LENGTH], date[11], time[6];
-        float duration;
-        char essentials[MAX_ESSENTIALS][MAX_STRING_LENGTH];
-        int count = 0;
-
-        token = strtok(NULL, " ");
-        if (token) strcpy(member_name, token);
-        token = strtok(NULL, " ");
-        if (token) strcpy(date, token);
-        token = strtok(NULL, " ");
-        if (token) strcpy(time, token);
-        token = strtok(NULL, " ");
-        if (token) duration = (float)atof(token);
-       
-        while ((token = strtok(NULL, " ")) != NULL && count < MAX_ESSENTIALS) {
-            if (token[strlen(token) - 1] == ';')
-                token[strlen(token) - 1] = '\0';
-            strcpy(essentials[count++], token);
-        }
-
-        Member* member = get_member(member_name);
-        if (!member) {
-            printf("Error: Invalid member name\n");
-            invalid_command_count++;
-            return;
-        }
-        add_reservation(member->name, date, time, duration, essentials, count);
-    }
-    else if (strcmp(token, "bookEssentials") == 0) {
-        char member_name[MAX_STRING_LENGTH], date[11], time[6];
-        float duration;
-        char essentials[MAX_ESSENTIALS][MAX_STRING_LENGTH];
-        int count = 0;
-
-        token = strtok(NULL, " ");
-        if (token) strcpy(member_name, token);
-        token = strtok(NULL, " ");
-        if (token) strcpy(date, token);
-        token = strtok(NULL, " ");
-        if (token) strcpy(time, token);
-        token = strtok(NULL, " ");
-        if (token) duration = (float)atof(token);
-       
-        while ((token = strtok(NULL, " ")) != NULL && count < MAX_ESSENTIALS) {
-            if (token[strlen(token) - 1] == ';')
-                token[strlen(token) - 1] = '\0';
-            strcpy(essentials[count++], token);
-        }
-
-        Member* member = get_member(member_name);
-        if (!member) {
-            printf("Error: Invalid member name\n");
-            invalid_command_count++;
-            return;
-        }
-        book_essentials(member->name, date, time, duration, essentials, count);
-    }
-    else if (strcmp(token, "addEvent") == 0) {
-        char member_name[MAX_STRING_LENGTH], date[11], time[6];
-        float duration;
-        char essentials[MAX_ESSENTIALS][MAX_STRING_LENGTH];
-        int count = 0;
-
-        token = strtok(NULL, " ");
-        if (token) strcpy(member_name, token);
-        token = strtok(NULL, " ");
-        if (token) strcpy(date, token);
-        token = strtok(NULL, " ");
-        if (token) strcpy(time, token);
-        token = strtok(NULL, " ");
-        if (token) duration = (float)atof(token);
-       
-        while ((token = strtok(NULL, " ")) != NULL && count < MAX_ESSENTIALS) {
-            if (token[strlen(token) - 1] == ';')
-                token[strlen(token) - 1] = '\0';
-            strcpy(essentials[count++], token);
-        }
+// Registry id of a member name stored in the journal or snapshot (-1 if unusable)
+static int restore_member(const char* stored) {
+    StrView name = {stored, (int)strnlen(stored, MAX_STRING_LENGTH)};
+    int id = get_member(name);
+    return id >= 0 ? id : add_member(name);
+}
 
-        Member* member = get_member(member_name);
-        if (!member) {
-            printf("Error: Invalid member name\n");
-            invalid_command_count++;
-            return;
-        }
-        add_event(member->name, date, time, duration, essentials, count);
+// Every booking of the mapped chunks has a member of the snapshot and a known type
+static bool snapshot_bookings_valid(const char* chunks, const SnapshotHeader* header) {
+    for (int i = 0; i < header->booking_count; i++) {
+        const char* chunk = chunks + (size_t)(i >> BOOKING_CHUNK_SHIFT) * sizeof(BookingChunk);
+        int k = i & BOOKING_CHUNK_MASK;
+        int member;
+        unsigned char type;
+        memcpy(&member, chunk + offsetof(BookingChunk, member) + k * sizeof(int), sizeof(int));
+        memcpy(&type, chunk + offsetof(BookingChunk, priority) + k, 1);
+        if (member < 0 || member >= header->member_count || type >= PRIORITY_LEVELS) return false;
     }
+    return true;
 }
 
-
-/* Output Module */
-// Print all bookings
-static void print_bookings(Booking* bookings, int booking_count, int* acceptList, int acceptCounter, char *algorithms) {
-    FILE *fp = fopen("SPMS_Report_G34.txt", "a");
-    if (!fp) {
-        perror("Failed to open report file");
-        return;
+// Load the snapshot into the empty store, returns the number of bookings
+static int restore_snapshot(void) {
+    int fd = open(snapshot_path, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(SnapshotHeader)) {
+        close(fd);
+        return 0;
     }
-    
-    // Create tracking array for accepted bookings
-    bool* is_accepted = calloc(booking_count, sizeof(bool));
-    for (int i = 0; i < acceptCounter; i++) {
-        if (acceptList[i] < booking_count) {
-            is_accepted[acceptList[i]] = true;
-        }
+    const char* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        perror("Unable to map snapshot");
+        return 0;
     }
-
-    // Print ACCEPTED bookings
-    fprintf(fp, "\n*** ACCEPTED Bookings - %s ***\n", algorithms);
-    for (int i = 0; i < MAX_USERS; i++) {
-        bool has_accepted = false;
-
-        // Check if member has any accepted bookings
-        for (int j = 0; j < acceptCounter; j++) {
-            int idx = acceptList[j];
-            if (idx < booking_count && strcmp(bookings[idx].member, members[i].name) == 0) {
-                has_accepted = true;
-                break;
-            }
+    madvise((void*)data, st.st_size, MADV_SEQUENTIAL);
+
+    // The counts must describe exactly the file, checked before they size anything
+    SnapshotHeader header;
+    memcpy(&header, data, sizeof(header));
+    size_t body = st.st_size - sizeof(header);
+    long chunks = ((long)header.booking_count + BOOKING_CHUNK_SIZE - 1) >> BOOKING_CHUNK_SHIFT;
+    if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.chunk_bytes != (int)sizeof(BookingChunk) || header.booking_count < 0 || header.member_count < 0 ||
+        (size_t)header.member_count > body / sizeof(Member) ||
+        (size_t)chunks != (body - header.member_count * sizeof(Member)) / sizeof(BookingChunk) ||
+        (body - header.member_count * sizeof(Member)) % sizeof(BookingChunk) != 0 ||
+        !snapshot_bookings_valid(data + sizeof(header) + header.member_count * sizeof(Member), &header)) {
+        fprintf(stderr, "Error: Snapshot %s is damaged and was not loaded.\n", snapshot_path);
+        munmap((void*)data, st.st_size);
+        return 0;
+    }
+    size_t chunk_offset = sizeof(header) + header.member_count * sizeof(Member);
+
+    // Snapshot member ids -> registry ids
+    const Member* stored = (const Member*)(data + sizeof(header));
+    int* member_ids = malloc((header.member_count + 1) * sizeof(int));
+    if (!member_ids) {
+        fprintf(stderr, "Failed to allocate memory.\n");
+        exit(1);
+    }
+    bool same_ids = true;
+    for (int m = 0; m < header.member_count; m++) {
+        member_ids[m] = restore_member(stored[m].name);
+        if (member_ids[m] < 0) {
+            fprintf(stderr, "Error: Snapshot %s is damaged and was not loaded.\n", snapshot_path);
+            free(member_ids);
+            munmap((void*)data, st.st_size);
+            return 0;
         }
+        same_ids = same_ids && member_ids[m] == m;
+    }
 
-        if (has_accepted) {
-            fprintf(fp, "\n%s has the following ACCEPTED bookings:\n", members[i].name);
-            fprintf(fp, "Date        Start  End    Type           Device\n");
-            fprintf(fp, "===========================================================================\n");
-
-            for (int j = 0; j < acceptCounter; j++) {
-                int idx = acceptList[j];
-                if (idx >= booking_count) continue;
-
-                Booking *b = &bookings[idx];
-                if (strcmp(b->member, members[i].name) == 0) {
-                    // Calculate end time
-                    char end_time[6];
-                    int start_hour, start_minute;
-                    sscanf(b->time, "%d:%d", &start_hour, &start_minute);
-                    int end_hour = start_hour + (int)b->duration;
-                    int end_minute = start_minute + (int)((b->duration - (int)b->duration) * 60);
-                    if (end_minute >= 60) {
-                        end_hour += end_minute / 60;
-                        end_minute %= 60;
-                    }
-                    sprintf(end_time, "%02d:%02d", end_hour, end_minute);
-
-                    // Print booking details
-                    fprintf(fp, "%s  %s  %s  %-14s", b->date, b->time, end_time, b->type);
-
-                    if (b->essential_count > 0) {
-                        char processed_essentials[MAX_ESSENTIALS][MAX_STRING_LENGTH] = {0};
-                        int processed_count = 0;
-                    
-                        for (int k = 0; k < b->essential_count; k++) {  
-                            char current_essential[MAX_STRING_LENGTH];
-                            strncpy(current_essential, b->essentials[k], MAX_STRING_LENGTH - 1);
-                            current_essential[MAX_STRING_LENGTH - 1] = '\0';
-                            to_lower_case(current_essential);
-                    
-                            // check whether processed the device
-                            bool processed = false;
-                            for (int p = 0; p < processed_count; p++) {
-                                if (strcmp(current_essential, processed_essentials[p]) == 0) {
-                                    processed = true;
-                                    break;
-                                }
-                                const char* pair = get_pair_essential(current_essential);
-                                if (pair && strcmp(pair, processed_essentials[p]) == 0) {
-                                    processed = true;
-                                    break;
-                                }
-                            }
-                    
-                            if (processed) {
-                                continue;
-                            }
-                    
-                            // process the current and its pair
-                            const char* pair = get_pair_essential(current_essential);
-                            fprintf(fp, " %s", b->essentials[k]); 
-                            if (pair) {
-                                fprintf(fp, "\n                                         %s", pair);
-                                strncpy(processed_essentials[processed_count], pair, MAX_STRING_LENGTH - 1);
-                                processed_count++;
-                            }
-                            // add to processed array
-                            strncpy(processed_essentials[processed_count], current_essential, MAX_STRING_LENGTH - 1);
-                            processed_count++;
-                        }
-                    } else {
-                        fprintf(fp, " *");
-                    }
-                    fprintf(fp, "\n");
-                }
-            }
+    reserve_bookings(&allBookings, header.booking_count);
+    for (long c = 0; c < chunks; c++) {
+        memcpy(allBookings.chunks[c], data + chunk_offset + c * sizeof(BookingChunk), sizeof(BookingChunk));
+    }
+    allBookings.booking_count = header.booking_count;
+    if (!same_ids) {
+        for (int i = 0; i < header.booking_count; i++) {
+            BOOKING_AT(&allBookings, member, i) = member_ids[BOOKING_AT(&allBookings, member, i)];
         }
     }
 
-    // Print REJECTED bookings
-    fprintf(fp, "\n*** REJECTED Bookings - %s ***\n", algorithms);
-    for (int i = 0; i < MAX_USERS; i++) {
-        bool has_rejected = false;
-
-        // Check if member has any rejected bookings
-        for (int j = 0; j < booking_count; j++) {
-            if (!is_accepted[j] && strcmp(bookings[j].member, members[i].name) == 0) {
-                has_rejected = true;
-                break;
-            }
-        }
+    free(member_ids);
+    munmap((void*)data, st.st_size);
+    return header.booking_count;
+}
 
-        if (has_rejected) {
-            fprintf(fp, "\n%s has the following REJECTED bookings:\n", members[i].name);
-            fprintf(fp, "Date        Start  End    Type           Device\n");
-            fprintf(fp, "===========================================================================\n");
-
-            for (int j = 0; j < booking_count; j++) {
-                if (!is_accepted[j] && strcmp(bookings[j].member, members[i].name) == 0) {
-                    Booking *b = &bookings[j];
-                   
-                    // Calculate end time
-                    char end_time[6];
-                    int start_hour, start_minute;
-                    sscanf(b->time, "%d:%d", &start_hour, &start_minute);
-                    int end_hour = start_hour + (int)b->duration;
-                    int end_minute = start_minute + (int)((b->duration - (int)b->duration) * 60);
-                    if (end_minute >= 60) {
-                        end_hour += end_minute / 60;
-                        end_minute %= 60;
-                    }
-                    sprintf(end_time, "%02d:%02d", end_hour, end_minute);
-
-                    // Print booking details
-                    fprintf(fp, "%s  %s  %s  %-14s", b->date, b->time, end_time, b->type);
-
-                    if (b->essential_count > 0) {
-                        char processed_essentials[MAX_ESSENTIALS][MAX_STRING_LENGTH] = {0};
-                        int processed_count = 0;
-                    
-                        for (int k = 0; k < b->essential_count; k++) {  
-                            char current_essential[MAX_STRING_LENGTH];
-                            strncpy(current_essential, b->essentials[k], MAX_STRING_LENGTH - 1);
-                            current_essential[MAX_STRING_LENGTH - 1] = '\0';
-                            to_lower_case(current_essential);
-                            bool processed = false;
-                            for (int p = 0; p < processed_count; p++) {
-                                if (strcmp(current_essential, processed_essentials[p]) == 0) {
-                                    processed = true;
-                                    break;
-                                }
-                                const char* pair = get_pair_essential(current_essential);
-                                if (pair && strcmp(pair, processed_essentials[p]) == 0) {
-                                    processed = true;
-                                    break;
-                                }
-                            }
-                    
-                            if (processed) {
-                                continue;
-                            }
-                    
-                            // process the current device and pair
-                            const char* pair = get_pair_essential(current_essential);
-                            fprintf(fp, " %s", b->essentials[k]); 
-                            if (pair) {
-                                fprintf(fp, "\n                                         %s", pair);
-                                // add to processed array
-                                strncpy(processed_essentials[processed_count], pair, MAX_STRING_LENGTH - 1);
-                                processed_count++;
-                            }
-                            strncpy(processed_essentials[processed_count], current_essential, MAX_STRING_LENGTH - 1);
-                            processed_count++;
-                        }
-                    } else {
-                        fprintf(fp, " *");
-                    }
-                    fprintf(fp, "\n");
-                }
-            }
+// Replay the journal records after the snapshot, returns the number of bookings added.
+// A torn or damaged tail (crash during a write) is cut off.
+static int replay_journal(void) {
+    int fd = open(journal_path, O_RDWR);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+    const JournalRecord* records = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (records == MAP_FAILED) {
+        perror("Unable to map journal");
+        close(fd);
+        return 0;
+    }
+    madvise((void*)records, st.st_size, MADV_SEQUENTIAL);
+
+    long record_count = st.st_size / sizeof(JournalRecord);
+    long valid = 0;
+    int replayed = 0;
+    for (; valid < record_count; valid++) {
+        const JournalRecord* rec = &records[valid];
+        if (rec->op != JOURNAL_ADD) {
+            // Changes set the booking's final state, so replaying one the snapshot has seen is harmless
+            if (rec->index < 0 || rec->index >= allBookings.booking_count || rec->op > JOURNAL_MODIFY) break;
+            if (rec->op == JOURNAL_CANCEL) cancel_stored_booking(rec->index);
+            else move_stored_booking(rec->index, rec->start, rec->duration);
+            continue;
         }
+        if (rec->index < allBookings.booking_count) continue; // already in the snapshot
+        if (rec->index != allBookings.booking_count || rec->type >= PRIORITY_LEVELS) break;
+        BookingRequest req = {PARSE_OK, restore_member(rec->member), rec->start, rec->duration, rec->type,
+                              rec->essentials};
+        if (req.member < 0) break;
+        create_booking(&req);
+        replayed++;
+    }
+    if ((off_t)(valid * sizeof(JournalRecord)) != st.st_size) {
+        fprintf(stderr, "Error: Journal %s has a damaged tail, %ld record(s) kept.\n", journal_path, valid);
+        if (ftruncate(fd, valid * sizeof(JournalRecord)) < 0) perror("Failed to truncate journal");
     }
 
-
-    free(is_accepted);
-    fprintf(fp, "\n- End -\n");
-    fprintf(fp, "===========================================================================\n");
-    fclose(fp);
+    munmap((void*)records, st.st_size);
+    close(fd);
+    return replayed;
 }
 
-/* Analyzer Module Functions */
-static int calculate_days_between(const char* start_date, const char* end_date) {
-    struct tm start_tm = {0}, end_tm = {0};
-    sscanf(start_date, "%d-%d-%d", &start_tm.tm_year, &start_tm.tm_mon, &start_tm.tm_mday);
-    sscanf(end_date, "%d-%d-%d", &end_tm.tm_year, &end_tm.tm_mon, &end_tm.tm_mday);
-
-    start_tm.tm_year -= 1900;
-    end_tm.tm_year -= 1900;
-    start_tm.tm_mon -= 1;
-    end_tm.tm_mon -= 1;
+// Restore the booking store from the directory, then journal new bookings there
+static void open_store(const char* directory) {
+    if (mkdir(directory, 0755) < 0 && errno != EEXIST) {
+        perror("Unable to create store directory");
+        return;
+    }
+    snprintf(journal_path, sizeof(journal_path), "%s/%s", directory, JOURNAL_FILE);
+    snprintf(snapshot_path, sizeof(snapshot_path), "%s/%s", directory, SNAPSHOT_FILE);
+
+    long long started = monotonic_ns();
+    int from_snapshot = restore_snapshot();
+    snapshot_count = from_snapshot;
+    int from_journal = replay_journal();
+    if (from_snapshot + from_journal > 0) {
+        printf("Restored %d booking(s) (%d from snapshot, %d from journal) in %.3f s\n",
+               from_snapshot + from_journal, from_snapshot, from_journal, (monotonic_ns() - started) / 1e9);
+    }
 
-    time_t start_time = mktime(&start_tm);
-    time_t end_time = mktime(&end_tm);
+    journal_buffer = malloc(JOURNAL_BUFFER_RECORDS * sizeof(JournalRecord));
+    if (!journal_buffer) {
+        fprintf(stderr, "Failed to allocate memory.\n");
+        exit(1);
+    }
+    journal_fd = open(journal_path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (journal_fd < 0) perror("Unable to open journal");
+}
 
-    return (int)difftime(end_time, start_time) / (60 * 60 * 24) + 1;
+// Fold the journal into a snapshot and stop journaling
+static void close_store(void) {
+    if (journal_fd < 0) return;
+    commit_journal();
+    if (allBookings.booking_count > snapshot_count) write_snapshot();
+    close(journal_fd);
+    journal_fd = -1;
+    free(journal_buffer);
+    journal_buffer = NULL;
 }
 
-int main() {
-    FILE *fp = fopen("SPMS_Report_G34.txt", "w");
+int main(int argc, char* argv[]) {
+    const char* store_directory = NULL;
+    for (int a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "-store") == 0 && a + 1 < argc) store_directory = argv[++a];
+        else {
+            fprintf(stderr, "Usage: %s [-store <directory>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    FILE *fp = fopen(REPORT_FILE, "w");
     if (fp) fclose(fp);
 
     printf("~~ WELCOME TO PolyU ~~\n");
-    init_booking_list(&allBookings, MAX_BOOKINGS);
+    load_members(MEMBERS_FILE);
+    load_capacities(CAPACITY_FILE);
+    init_slot_index();
+    init_shared_booking_list(&allBookings);
+    if (store_directory) open_store(store_directory);
    
-    // Create 4 pipes, a pair for each child
-    int ptoc_fd[3][2]; // parent to child
-    int ctop_fd[3][2]; // child to parent
+    // Create a pair of pipes for each child
+    int ptoc_fd[CHILD_COUNT][2]; // parent to child
+    int ctop_fd[CHILD_COUNT][2]; // child to parent
    
-    for (int i = 0; i < 3; i++) { // loop for 4 process
+    for (int i = 0; i < CHILD_COUNT; i++) {
         // Pipe Setup
         if (pipe(ptoc_fd[i]) < 0) {
             fprintf(stderr, "Error: PTOC pipe creation failed.\n");
@@ -835,7 +3453,8 @@ int main() {
         }
     }
 
-    for (int i = 0; i < 3; i++) {
+    fflush(stdout); // or the children inherit the buffered output and print it again on exit
+    for (int i = 0; i < CHILD_COUNT; i++) {
         int pid = fork();
         if (pid < 0) { // error occurred
             fprintf(stderr, "Error: Fork failed.\n");
@@ -847,327 +3466,171 @@ int main() {
             close(ptoc_fd[i][1]);
             close(ctop_fd[i][0]);
 
-            /* Scheduling Module - Child Process*/
-            if(i == 0) {
-                // char buf[256];
-                char msg[6] = {0}; // message passed from child to parent
-                char s_request[5000] = {0}; // to store scheduling request send over from parent
-
-                // Initialize signal protocol -> ensure all child's start before any booking starts
-                if (read(ptoc_fd[i][0], msg, 5) > 0 && strcmp(msg, "START") == 0){ //receive "START"
-                    write(ctop_fd[i][1], "READY", 5); // write "ready" to parent
-                }
-
-                // Allocate a accept list
-                int* acceptList = (int*)calloc(2500, sizeof(int));
-                if (acceptList == NULL) {
-                    fprintf(stderr, "Failed to allocate memory.\n");
-                    exit(1);
-                }
-
-                memset(s_request, 0, sizeof(s_request)); // clear
-                int user = 0;
-                char schedule = '0';
-               
-                while (1) {
-                    char algorithm[6] = {0};
-
-                    int bytes_read = read(ptoc_fd[0][0], algorithm, 6);
-                    if (bytes_read <= 0 || strcmp(algorithm, "EXIT") == 0) {
-                        break; // Exit the loop and terminate the child process
-                    }
-                    
-                    write(ctop_fd[0][1], "ACK_ALGO", 9);
-                   
-                    // Receive pending bookings count
-                    int pending_count;
-                    read(ptoc_fd[0][0], &pending_count, sizeof(int));
-                    write(ctop_fd[0][1], "ACK_READ", 9);
-       
-                    if (pending_count > 0) {
-                        Booking* pending = malloc(pending_count * sizeof(Booking));
-                        read(ptoc_fd[0][0], pending, pending_count * sizeof(Booking));
-                        write(ctop_fd[0][1], "ACK_SENT", 9);
-       
-                        // Process bookings
-                        int acceptList[MAX_BOOKINGS] = {0};
-                        int acceptCount = 0;
-                       
-                        if (strcmp(algorithm, "fcfs") == 0) {
-                            memset(acceptList, 0, sizeof(acceptList));
-                            FCFS_Scheduler(pending, pending_count, acceptList, &acceptCount);
-                        } 
-                        else if (strcmp(algorithm, "prio") == 0) {
-                            memset(acceptList, 0, sizeof(acceptList));
-                            Priority_Scheduler(pending, pending_count, acceptList, &acceptCount);
-                        }   
-       
-                        // Send results to parent
-                        char msg_p0[9];
-                        read(ptoc_fd[0][0], msg_p0, 9);
-                        if(strcmp(msg_p0, "ACK_OKAY") != 0) {
-                            break;
-                        }
-
-                        write(ctop_fd[0][1], &acceptCount, sizeof(int));
-                        read(ptoc_fd[0][0], msg_p0, 9);
-                        if(strcmp(msg_p0, "ACK_RECV") != 0) {
-                            break;
+            /* Scheduling Module - one child per algorithm */
+            if(i < ALGORITHM_COUNT) {
+                ModuleRequest req;
+                int type, index_count;
+                int* indices;
+
+                // Schedule kept between requests: fcfs and prio decide bookings in order, so
+                // only the bookings added since the last run are scheduled; opti schedules the
+                // days of those bookings again
+                int scheduled = 0;
+                int* acceptList = NULL;
+                int acceptCount = 0;
+                int algorithm = ALGORITHM_FCFS; // algorithm of the kept schedule
+
+                while (recv_message(ptoc_fd[i][0], &type, &req, &indices, &index_count)) {
+                    if (type == MSG_UPDATE) {
+                        // Bookings not scheduled yet are read from the store on the next run
+                        const BookingUpdate* updates = (const BookingUpdate*)indices;
+                        int update_count = index_count * sizeof(int) / sizeof(BookingUpdate);
+                        for (int k = 0; k < update_count; k++) {
+                            if (updates[k].booking >= scheduled) continue;
+                            if (algorithm == ALGORITHM_OPTI) requeue_booking(&allBookings, &updates[k]);
+                            else reschedule_booking(&allBookings, &updates[k], algorithm == ALGORITHM_PRIO);
                         }
+                        free(indices);
+                        continue;
+                    }
+                    free(indices);
+                    if (type == MSG_STATS) {
+                        send_stats(ctop_fd[i][1]);
+                        continue;
+                    }
+                    if (type != MSG_SCHEDULE) break;
+                    long long started = monotonic_ns();
+
+                    // Read the bookings in place from the shared store
+                    BookingList* pending = &allBookings;
+                    attach_booking_list(pending, req.booking_count);
+                    reset_schedule(pending, scheduled);
+
+                    // At most every booking is accepted
+                    int* grown = realloc(acceptList, (req.booking_count > 0 ? req.booking_count : 1) * sizeof(int));
+                    if (!grown) {
+                        fprintf(stderr, "Failed to allocate memory.\n");
+                        exit(1);
+                    }
+                    acceptList = grown;
 
-                        write(ctop_fd[0][1], acceptList, acceptCount * sizeof(int));
-                        char ack_list[9];
-                        read(ptoc_fd[0][0], ack_list, 9);
-                        if (strcmp(ack_list, "ACK_LIST") != 0) {
-                            break;
-                        }
-                       
-                        free(pending);
+                    long long scheduling = monotonic_ns();
+                    if (strcmp(req.algorithm, "fcfs") == 0) {
+                        algorithm = ALGORITHM_FCFS;
+                        acceptCount = schedule_bookings(pending, scheduled, algorithm, acceptList);
+                        record_stage(&stage_stats[STAGE_FCFS], monotonic_ns() - scheduling);
+                    }
+                    else if (strcmp(req.algorithm, "prio") == 0) {
+                        algorithm = ALGORITHM_PRIO;
+                        acceptCount = schedule_bookings(pending, scheduled, algorithm, acceptList);
+                        record_stage(&stage_stats[STAGE_PRIO], monotonic_ns() - scheduling);
+                    }
+                    else if (strcmp(req.algorithm, "opti") == 0) {
+                        algorithm = ALGORITHM_OPTI;
+                        acceptCount = schedule_bookings(pending, scheduled, algorithm, acceptList);
+                        record_stage(&stage_stats[STAGE_OPTI], monotonic_ns() - scheduling);
                     }
+                    scheduled = req.booking_count;
+
+                    // Send results to parent
+                    req.work_ns = monotonic_ns() - started;
+                    send_message(ctop_fd[i][1], MSG_RESULT, &req, acceptList, acceptCount);
                 }
+                free(acceptList);
             }
             
            
             /* Output Module - Child Process*/
-            else if (i == 1) {  // 2nd Child -> Ouput Module
-
-                close(ptoc_fd[i][1]); // Close parent's write end
-                close(ctop_fd[i][0]); // Close parent's read end
-                // receive from parent
-               
-                char msg[6] = {0};
-                if (read(ptoc_fd[i][0], msg, 5) > 0 && strcmp(msg, "START") == 0) {
-                    write(ctop_fd[i][1], "READY", 5); // Send "READY" acknowledgment to parent
-                }
-
-                while (1) {
-                    char algorithm[6] = {0};
-
-                    int algo_read = read(ptoc_fd[1][0], algorithm, 6);
-                    if (algo_read <= 0) break;
-
-                    if (algo_read <= 0 || strcmp(algorithm, "EXIT") == 0) {
-                        break; // Exit the loop and terminate the child process
-                    }
-
-                    write(ctop_fd[1][1], "ACK_ALGO", 9);
-
-                    int schedCount = 0;
-                    if (read(ptoc_fd[1][0], &schedCount, sizeof(int)) > 0) {
-
-                        write(ctop_fd[1][1], "ACK_COUNTER", 12);
-                    }
-               
-                    Booking* schedList = malloc(schedCount * sizeof(Booking));
-                    if (!schedList) {
-                        fprintf(stderr, "Error: Failed to allocate memory for Booking List.\n");
-                        break;
+            else if (i == CHILD_OUTPUT) {
+                ModuleRequest req;
+                int type, acceptCount;
+                int* acceptIdx;
+                ReportSection sections[ALGORITHM_COUNT] = {{0}};
+                FILE* exports[FORMAT_COUNT] = {NULL};
+
+                while (recv_message(ptoc_fd[i][0], &type, &req, &acceptIdx, &acceptCount)) {
+                    long long started = monotonic_ns();
+                    if (type == MSG_REPORT && req.section >= 0 && req.section < ALGORITHM_COUNT) {
+                        BookingList* schedList = &allBookings;
+                        attach_booking_list(schedList, req.booking_count);
+                        if (req.format == FORMAT_TEXT) {
+                            FILE* fp = open_section(&sections[req.section]);
+                            print_bookings(fp, schedList, acceptIdx, acceptCount, req.algorithm);
+                            fclose(fp);
+                        } else {
+                            export_bookings(exports, req.format, schedList, acceptIdx, acceptCount,
+                                            req.algorithm, req.section);
+                        }
+                        record_stage(&stage_stats[STAGE_PRINT_BOOKINGS], monotonic_ns() - started);
+                        free(acceptIdx);
                     }
-               
-                    if (read(ptoc_fd[1][0], schedList, schedCount * sizeof(Booking)) > 0) {
-                        write(ctop_fd[1][1], "ACK_LIST", 9);
+                    else if (type == MSG_FLUSH) {
+                        flush_sections(sections, ALGORITHM_COUNT);
+                        flush_exports(exports);
                     }
-
-                    int acceptCount = 0;
-                    if (read(ptoc_fd[1][0], &acceptCount, sizeof(int)) > 0) {
-                        write(ctop_fd[1][1], "ACK_COUNTER", 12);
+                    else if (type == MSG_STATS) {
+                        free(acceptIdx);
+                        send_stats(ctop_fd[i][1]);
+                        continue;
                     }
-
-                    int* acceptIdx = malloc(acceptCount * sizeof(int));
-                    if (read(ptoc_fd[1][0], acceptIdx, acceptCount * sizeof(Booking)) > 0) {
-                        print_bookings(schedList, schedCount, acceptIdx, acceptCount, algorithm);
-                        write(ctop_fd[1][1], "ACK_INDX", 9);
+                    else {
+                        free(acceptIdx);
+                        break;
                     }
-               
-                    free(schedList);
-                    free(acceptIdx);
+                    ModuleRequest reply = {0};
+                    reply.work_ns = monotonic_ns() - started;
+                    send_message(ctop_fd[i][1], MSG_DONE, &reply, NULL, 0);
                 }
             }
 
 
-            /* Analyzer Module - 3rd Child */
-            else if (i == 2) {
-                close(ptoc_fd[i][1]); // Close parent's write end
-                close(ctop_fd[i][0]); // Close parent's read end
-
-                while (1) {
-
-                    char algorithm[6] = {0};
-
-                    // Receive algorithm name
-                    int bytes_read = read(ptoc_fd[i][0], algorithm, sizeof(algorithm));
-                    if (bytes_read <= 0 || strcmp(algorithm, "EXIT") == 0) {
-                        break; // Exit the loop and terminate the child process
-                    }
-
-                    write(ctop_fd[i][1], "ACK_ALGO", 9); // Send acknowledgment
-
-                    int pending_count = 0;
-
-                    // Receive pending count
-                    if (read(ptoc_fd[i][0], &pending_count, sizeof(int)) <= 0) {
-                        break; // Exit if no data is received
-                    }
-                    write(ctop_fd[i][1], "ACK_COUNTER", 12); // Send acknowledgment
-            
-                    // Allocate memory for pending bookings
-                    Booking* pending_bookings = malloc(pending_count * sizeof(Booking));
-                    if (!pending_bookings) {
-                        fprintf(stderr, "Analyzer: Memory allocation failed for pending bookings.\n");
-                        free(pending_bookings);
-                        break;
-                    }
-            
-                    // Receive pending bookings
-                    if (read(ptoc_fd[i][0], pending_bookings, pending_count * sizeof(Booking)) <= 0) {
-                        free(pending_bookings);
-                        break; // Exit if no data is received
-                    }
-                    write(ctop_fd[i][1], "ACK_LIST", 9); // Send acknowledgment
-            
-                    int accept_count = 0;
-            
-                    // Receive accepted count
-                    if (read(ptoc_fd[i][0], &accept_count, sizeof(int)) <= 0) {
-                        free(pending_bookings);
-                        break; // Exit if no data is received
-                    }
-                    write(ctop_fd[i][1], "ACK_COUNTER", 12); // Send acknowledgment
-            
-                    // Allocate memory for accepted indices
-                    int* accepted_indices = malloc(accept_count * sizeof(int));
-                    if (!accepted_indices) {
-                        fprintf(stderr, "Analyzer: Memory allocation failed for accepted indices.\n");
-                        free(pending_bookings);
+            /* Analyzer Module - Child Process */
+            else if (i == CHILD_ANALYZER) {
+                ModuleRequest req;
+                int type, accept_count;
+                int* accepted_indices;
+                ReportSection sections[ALGORITHM_COUNT] = {{0}};
+                FILE* exports[FORMAT_COUNT] = {NULL};
+
+                while (recv_message(ptoc_fd[i][0], &type, &req, &accepted_indices, &accept_count)) {
+                    long long started = monotonic_ns();
+                    if (type == MSG_ANALYZE && req.section >= 0 && req.section < ALGORITHM_COUNT) {
+                        // Read the bookings in place from the shared store
+                        BookingList* pending_bookings = &allBookings;
+                        attach_booking_list(pending_bookings, req.booking_count);
+                        SummaryMetrics metrics;
+                        compute_summary(&metrics, pending_bookings, req.booking_count,
+                                        accepted_indices, accept_count, req.invalid_count);
+                        if (req.format == FORMAT_TEXT) {
+                            OccupancyMetrics occupancy;
+                            compute_occupancy(&occupancy, pending_bookings, req.booking_count,
+                                              accepted_indices, accept_count, &metrics);
+                            FILE* fp = open_section(&sections[req.section]);
+                            print_summary(fp, &metrics, req.algorithm);
+                            print_occupancy(fp, &occupancy);
+                            fclose(fp);
+                        } else {
+                            export_summary(exports, req.format, &metrics, req.algorithm, req.section);
+                        }
+                        record_stage(&stage_stats[STAGE_ANALYZER], monotonic_ns() - started);
                         free(accepted_indices);
-                        exit(1);
                     }
-            
-                    // Receive accepted indices
-                    if (read(ptoc_fd[i][0], accepted_indices, accept_count * sizeof(int)) <= 0) {
-                        free(pending_bookings);
-                        free(accepted_indices);
-                        break; // Exit if no data is received
+                    else if (type == MSG_FLUSH) {
+                        flush_sections(sections, ALGORITHM_COUNT);
+                        flush_exports(exports);
                     }
-                    write(ctop_fd[i][1], "ACK_INDX", 9); // Send acknowledgment
-
-                    // Receive invalid_command_count
-                    int received_invalid_count = 0;
-                    if (read(ptoc_fd[i][0], &received_invalid_count, sizeof(int)) <= 0) {
-                        free(pending_bookings);
+                    else if (type == MSG_STATS) {
                         free(accepted_indices);
-                        break; // Exit if no data is received
+                        send_stats(ctop_fd[i][1]);
+                        continue;
                     }
-                    write(ctop_fd[i][1], "ACK_INVALID", 12); // Send acknowledgment
-
-                    // Analyzer Module: Process bookings and generate the report
-                    FILE* fp = fopen("SPMS_Report_G34.txt", "a");
-                    if (!fp) {
-                        perror("Analyzer: Failed to open report file");
-                    } else {
-                        fprintf(fp, "\n*** Parking Booking Manager – Summary Report ***\n");
-
-                        // Find the earliest and latest booking dates
-                        char earliest_date[11] = "9999-12-31";
-                        char latest_date[11] = "0000-01-01";
-                        for (int i = 0; i < pending_count; i++) {
-                            if (strcmp(pending_bookings[i].date, earliest_date) < 0) {
-                                strcpy(earliest_date, pending_bookings[i].date);
-                            }
-                            if (strcmp(pending_bookings[i].date, latest_date) > 0) {
-                                strcpy(latest_date, pending_bookings[i].date);
-                            }
-                        }
-
-                        int test_days = calculate_days_between(earliest_date, latest_date);
-                        fprintf(fp, "Test Period: %s to %s (%d days)\n", earliest_date, latest_date, test_days);
-
-                        // Performance for two algorithms
-                        fprintf(fp, "\nPerformance:\nFor %s:\n", algorithm);
-                        fprintf(fp, "Total Number of Bookings Received: %d\n", pending_count);
-                        fprintf(fp, "Number of Bookings Assigned: %d\n", accept_count);
-                        fprintf(fp, "Number of Bookings Rejected: %d\n", pending_count - accept_count);
-
-                        // Calculate Time Slot Utilization
-                        int total_slots = test_days * 24 * 3; // Total slots = days * 24 hours * 3
-                        float total_occupied_hours = 0;
-                        for (int i = 0; i < accept_count; i++) {
-                            int idx = accepted_indices[i];
-                            total_occupied_hours += pending_bookings[idx].duration; // Sum durations of accept bookings
-                        }
-                        float time_slot_utilization = (total_occupied_hours / total_slots) * 100;
-                        fprintf(fp, "Utilization of Time Slot: %.1f%%\n", time_slot_utilization);
-
-                        // Calculate Resource Utilization
-                        int locker_used = 0, battery_used = 0, cable_used = 0, umbrella_used = 0, valet_used = 0, inflation_used = 0;
-                        for (int i = 0; i < accept_count; i++) {
-                            int idx = accepted_indices[i];
-                            int current_duration = pending_bookings[idx].duration;
-                            
-                            char processed_essentials[MAX_ESSENTIALS][MAX_STRING_LENGTH] = {0};
-                            int processed_count = 0;
-                            
-                            for (int j = 0; j < pending_bookings[idx].essential_count; j++) {
-                                char current_essential[MAX_STRING_LENGTH];
-                                strncpy(current_essential, pending_bookings[idx].essentials[j], MAX_STRING_LENGTH - 1);
-                                current_essential[MAX_STRING_LENGTH - 1] = '\0';
-                                to_lower_case(current_essential);
-                                
-                                // check whether has processed before
-                                bool processed = false;
-                                const char* pair = get_pair_essential(current_essential);
-                                
-                                for (int p = 0; p < processed_count; p++) {
-                                    if (strcmp(current_essential, processed_essentials[p]) == 0 || 
-                                        (pair && strcmp(pair, processed_essentials[p]) == 0)) {
-                                        processed = true;
-                                        break;
-                                    }
-                                }
-
-                                if (!processed) {
-                                    // for current device
-                                    if (strcmp(current_essential, "locker") == 0) locker_used += current_duration;
-                                    else if (strcmp(current_essential, "battery") == 0) battery_used += current_duration;
-                                    else if (strcmp(current_essential, "cable") == 0) cable_used += current_duration;
-                                    else if (strcmp(current_essential, "umbrella") == 0) umbrella_used += current_duration;
-                                    else if (strcmp(current_essential, "valetpark") == 0) valet_used += current_duration;
-                                    else if (strcmp(current_essential, "inflationservice") == 0) inflation_used += current_duration;
-
-                                    // staticstic for paired
-                                    if (pair) {
-                                        if (strcmp(pair, "locker") == 0) locker_used += current_duration;
-                                        else if (strcmp(pair, "battery") == 0) battery_used += current_duration;
-                                        else if (strcmp(pair, "cable") == 0) cable_used += current_duration;
-                                        else if (strcmp(pair, "umbrella") == 0) umbrella_used += current_duration;
-                                        else if (strcmp(pair, "valetpark") == 0) valet_used += current_duration;
-                                        else if (strcmp(pair, "inflationservice") == 0) inflation_used += current_duration;
-                                    }
-
-                                    // mark as processed
-                                    strncpy(processed_essentials[processed_count], current_essential, MAX_STRING_LENGTH - 1);
-                                    processed_count++;
-                                    if (pair) {
-                                        strncpy(processed_essentials[processed_count], pair, MAX_STRING_LENGTH - 1);
-                                        processed_count++;
-                                    }
-                                }
-                            }
-                        }
-
-                        fprintf(fp, "\nResource Utilization:\n");
-                        fprintf(fp, "Locker - %.1f%%\n", (locker_used / (float)(test_days * 24 * MAX_RESOURCES)) * 100);
-                        fprintf(fp, "Battery - %.1f%%\n", (battery_used / (float)(test_days * 24 * MAX_RESOURCES)) * 100);
-                        fprintf(fp, "Cable - %.1f%%\n", (cable_used / (float)(test_days * 24 * MAX_RESOURCES)) * 100);
-                        fprintf(fp, "Umbrella - %.1f%%\n", (umbrella_used / (float)(test_days * 24 * MAX_RESOURCES)) * 100);
-                        fprintf(fp, "Valet - %.1f%%\n", (valet_used / (float)(test_days * 24 * MAX_RESOURCES)) * 100);
-                        fprintf(fp, "Inflation - %.1f%%\n", (inflation_used / (float)(test_days * 24 * MAX_RESOURCES)) * 100);
-
-                        // Invalid Requests
-                        fprintf(fp, "\nInvalid request(s) made: %d\n", received_invalid_count);
-
-                        fclose(fp);
+                    else {
+                        free(accepted_indices);
+                        break;
                     }
+                    ModuleRequest reply = {0};
+                    reply.work_ns = monotonic_ns() - started;
+                    send_message(ctop_fd[i][1], MSG_DONE, &reply, NULL, 0);
                 }
             }
             //close used pipe ends
@@ -1180,301 +3643,278 @@ int main() {
 
     // Parent process
     // Close unused pipe ends
-    for (int j = 0; j < 3; j++) {
+    for (int j = 0; j < CHILD_COUNT; j++) {
         close(ptoc_fd[j][0]);
         close(ctop_fd[j][1]);
     }
 
-    // Parent signal child proceses to start -> parallel processing
-    for(int j = 0; j < 2; j++){
-        write(ptoc_fd[j][1], "START", 5);
-    }
-
-    // Wait for "READY" from child
-    for(int k = 0; k < 2; k++){
-        char ready_msg[6] = {0};
-        if (read(ctop_fd[k][0], ready_msg, sizeof(ready_msg) - 1) > 0 && strcmp(ready_msg, "READY") == 0) {
-            // printf("Parent received READY signal from Child %d.\n", k);
-        }
-    }
-
     char input[256] = {0};
-    while(1) {
+    int report_format = FORMAT_TEXT;
+    bool running = true;
+    while (running) {
+        commit_journal();
         printf("\nPlease enter booking:\n");
+        fflush(stdout); // stdout is fully buffered when it is a pipe
         if (fgets(input, sizeof(input), stdin) == NULL) {
             break;
         }
         input[strcspn(input, "\n")] = 0;
-        char test[256];
-        strcpy(test, input);
 
-        // NEED EDIT
-        if (strcmp(input, "endProgram;") == 0) {
+        const char* cur = input;
+        const char* end = input + strlen(input);
+        StrView keyword, argument;
+        if (!next_token(&cur, end, &keyword)) continue;
+        const Command* command = find_command(keyword);
+        int command_id = command ? command->command : CMD_UNKNOWN;
+
+        // Without arguments the ';' was part of these keywords, they still need it
+        if ((command_id == CMD_PRINT_MEMORY || command_id == CMD_STATS || command_id == CMD_END_PROGRAM) &&
+            !ends_command(input, end)) {
+            command_id = CMD_UNKNOWN;
+        }
+
+        switch (command_id) {
+        case CMD_END_PROGRAM:
             printf("-> Bye!\n");
         
             // Send termination signal to all child processes
-            for (int i = 0; i < 3; i++) {
-                write(ptoc_fd[i][1], "EXIT", 5);
+            for (int i = 0; i < CHILD_COUNT; i++) {
+                send_message(ptoc_fd[i][1], MSG_EXIT, NULL, NULL, 0);
             }
         
             // Wait for all child processes to terminate
-            for (int i = 0; i < 3; i++) {
+            for (int i = 0; i < CHILD_COUNT; i++) {
                 int status;
                 waitpid(-1, &status, 0);
             }
         
-            free(allBookings.bookings);
+            close_store();
+            free_booking_list(&allBookings);
             free(fcfs_results.accepted_idx);
             free(fcfs_results.rejected_idx);
             free(prio_results.accepted_idx);
             free(prio_results.rejected_idx);
+            free(opti_results.accepted_idx);
+            free(opti_results.rejected_idx);
+            running = false;
             break;
-        }
-       
-        char *token = strtok(input, " ");
-        if (token == NULL) continue;
 
-        if(strcmp(token, "addParking") == 0 ||
-            strcmp(token, "addReservation") == 0 ||
-            strcmp(token, "bookEssentials") == 0 ||
-            strcmp(token, "addEvent") == 0) {
-            command_processor(test);
-        }
+        case CMD_BOOKING:
+            command_processor(input);
+            break;
 
-        else if (strcmp(token, "printBookings") == 0) {
+        case CMD_PRINT_BOOKINGS: {
             char algorithm[6] = {0};
-            token = strtok(NULL, " ");
-
-            if (token) {
-                strncpy(algorithm, token + 1, sizeof(algorithm) - 1); // Skip the leading dash
-                algorithm[sizeof(algorithm) - 1] = '\0'; // Ensure null-termination
-        
-                // Find the last semicolon in the string and remove it
-                char* last_semicolon = strrchr(algorithm, ';');
-                if (*last_semicolon != ';') {
+            if (next_token(&cur, end, &argument)) {
+                if (!ends_command(input, end)) {
                     printf("Error: Command must end with a semicolon\n");
                     invalid_command_count++;
                     continue;
                 }
-                if (last_semicolon) {
-                    *last_semicolon = '\0'; // Replace the semicolon with a null terminator
-                }
+                // Skip the leading dash
+                int len = argument.len - 1 < (int)sizeof(algorithm) - 1 ? argument.len - 1 : (int)sizeof(algorithm) - 1;
+                if (len > 0) memcpy(algorithm, argument.ptr + 1, len);
             }
 
-            const char* algorithms[] = {"fcfs", "prio"};
-            SchedulerResults* results[] = {&fcfs_results, &prio_results};
-            int numAlgorithms = 2;
-            int start = 0;
-
-            if (strcmp(algorithm, "fcfs") == 0) numAlgorithms = 1;
-            else if (strcmp(algorithm, "prio") == 0) start = 1;
-
-            Booking* pending_bookings;
-            int pending_count = 0;
-            int acceptCounter = 0;
-            SchedulerResults* res;
-
-            for (int a = start; a < numAlgorithms; a++) {
-                // Send algorithm string to Scheduler (child 0)
-                write(ptoc_fd[0][1], algorithms[a], 6);
-                char ack_algo[9] = {0};
-                read(ctop_fd[0][0], ack_algo, 9);
-                if (strcmp(ack_algo, "ACK_ALGO") != 0) {
-                    fprintf(stderr, "Parent: Missing ACK_ALGO\n");
-                    break;
-                }
-
-                // Get pending bookings (assume allBookings.booking_count is total pending)
-                pending_count = allBookings.booking_count;
-                pending_bookings = malloc(pending_count * sizeof(Booking));
-                if (pending_count == 0) {
-                    printf("Error: No pending bookings available for processing.\n");
-                    invalid_command_count++; // Increment invalid command count
-                    break;
-                }
-                if (!pending_bookings) {
-                    fprintf(stderr, "Error: Memory allocation for pending bookings failed.\n");
-                    break;
-                }
+            const char* algorithms[ALGORITHM_COUNT] = {"fcfs", "prio", "opti"};
+            SchedulerResults* results[ALGORITHM_COUNT] = {&fcfs_results, &prio_results, &opti_results};
+            bool analyze = strcmp(algorithm, "ALL") == 0;
 
-                for (int i = 0; i < allBookings.booking_count; i++) {
-                    if (allBookings.bookings[i].status == STATUS_PENDING) {
-                        memcpy(&pending_bookings[i], &allBookings.bookings[i], sizeof(Booking));
-                    }
+            // A single algorithm by name, all of them with ALL, otherwise fcfs and prio
+            bool selected[ALGORITHM_COUNT] = {true, true, analyze};
+            for (int a = 0; a < ALGORITHM_COUNT; a++) {
+                if (strcmp(algorithm, algorithms[a]) == 0) {
+                    for (int b = 0; b < ALGORITHM_COUNT; b++) selected[b] = b == a;
                 }
+            }
 
-                // Send pending count and bookings to Scheduler
-                write(ptoc_fd[0][1], &pending_count, sizeof(int));
-                char ack_read[9] = {0};
-                read(ctop_fd[0][0], ack_read, 9);
-                if (strcmp(ack_read, "ACK_READ") != 0) {
-                    break;
-                }
-                write(ptoc_fd[0][1], pending_bookings, pending_count * sizeof(Booking));
-                char ack_sent[9] = {0};
-                read(ctop_fd[0][0], ack_sent, 9);
-                if (strcmp(ack_sent, "ACK_SENT") != 0) {
-                    break;
-                }
+            // Each Scheduler worker only schedules the bookings it has not seen yet
+            int pending_count = allBookings.booking_count;
+            if (pending_count == 0) {
+                printf("Error: No pending bookings available for processing.\n");
+                invalid_command_count++; // Increment invalid command count
+                continue;
+            }
 
-                // Tell scheduler that we're ready to receive results
-                write(ptoc_fd[0][1], "ACK_OKAY", 9);
-                res = results[a];
-                res->total_received = pending_count;
-                read(ctop_fd[0][0], &acceptCounter, sizeof(int));
-                write(ptoc_fd[0][1], "ACK_RECV", 9);
-                res->accepted_idx = malloc(acceptCounter * sizeof(int));
-                if (!res->accepted_idx) {
-                    fprintf(stderr, "Error: Memory allocation for acceptList failed.\n");
-                    break;
-                }
-                read(ctop_fd[0][0], res->accepted_idx, acceptCounter * sizeof(int));
-                write(ptoc_fd[0][1], "ACK_LIST", 9);
-                res->accepted_count = acceptCounter;
-
-                // Update rejected bookings in SchedulerResults
-                res->rejected_count = 0;
-                res->rejected_idx = malloc(pending_count * sizeof(int)); // worst-case
-                if (!res->rejected_idx) {
-                    fprintf(stderr, "Error: Memory allocation for rejectList failed.\n");
-                    free(pending_bookings);
-                    free(res->accepted_idx);
-                    exit(1);
-                }
-                
-                int m = 0; // Pointer to the next accepted index
-                for (int i = 0; i < pending_count; i++) {
-                    if (m < acceptCounter && i == res->accepted_idx[m]) {
-                        m++; // Skip accepted bookings
-                    } else {
-                        res->rejected_idx[res->rejected_count++] = i;
-                    }
+            // Start every requested algorithm on its own Scheduler worker
+            long long started = monotonic_ns();
+            long long scheduler_ns = 0, output_ns = 0, analyzer_ns = 0;
+            struct pollfd workers[ALGORITHM_COUNT];
+            int running = 0;
+            for (int a = 0; a < ALGORITHM_COUNT; a++) {
+                ModuleRequest req = {.section = a, .booking_count = pending_count,
+                                     .invalid_count = invalid_command_count, .format = report_format};
+                strcpy(req.algorithm, algorithms[a]);
+                workers[a].fd = -1; // poll() skips negative descriptors
+                workers[a].events = POLLIN;
+                if (!selected[a]) continue;
+                if (!send_message(ptoc_fd[a][1], MSG_SCHEDULE, &req, NULL, 0)) {
+                    fprintf(stderr, "Parent: Scheduler Module %s is not running.\n", algorithms[a]);
+                    continue;
                 }
+                workers[a].fd = ctop_fd[a][0];
+                running++;
+            }
 
-                // Forward results to Output Module
-                write(ptoc_fd[1][1], algorithms[a], 6);
+            // Hand each result to the Output and Analyzer modules as soon as its worker finishes
+            int output_replies = 0, analyzer_replies = 0;
+            while (running > 0) {
+                if (poll(workers, ALGORITHM_COUNT, -1) < 0) break;
 
-                char ack_algo_c1[9];
-                read(ctop_fd[1][0], ack_algo_c1, 9); // Wait for ACK_ALGO from Child 1
-                if (strcmp(ack_algo_c1, "ACK_ALGO") != 0) {
-                    break;;
-                }
+                for (int a = 0; a < ALGORITHM_COUNT; a++) {
+                    if (workers[a].fd < 0 || !workers[a].revents) continue;
+                    workers[a].fd = -1;
+                    running--;
 
-                write(ptoc_fd[1][1], &pending_count, sizeof(int)); // Send pending count
+                    SchedulerResults* res = results[a];
+                    ModuleRequest req = {.section = a, .booking_count = pending_count,
+                                         .invalid_count = invalid_command_count, .format = report_format};
+                    strcpy(req.algorithm, algorithms[a]);
+                    int type;
+                    free(res->accepted_idx);
+                    if (!recv_message(ctop_fd[a][0], &type, &req, &res->accepted_idx, &res->accepted_count) ||
+                        type != MSG_RESULT) {
+                        fprintf(stderr, "Parent: No result from Scheduler Module %s.\n", algorithms[a]);
+                        res->accepted_count = 0;
+                        continue;
+                    }
+                    res->total_received = pending_count;
+                    if (req.work_ns > scheduler_ns) scheduler_ns = req.work_ns; // the workers run in parallel
+                    req.work_ns = 0;
+
+                    // Update rejected bookings in SchedulerResults
+                    free(res->rejected_idx);
+                    res->rejected_count = 0;
+                    res->rejected_idx = malloc(pending_count * sizeof(int)); // worst-case
+                    bool* is_accepted = calloc(pending_count, sizeof(bool));
+                    if (!res->rejected_idx || !is_accepted) {
+                        fprintf(stderr, "Error: Memory allocation for rejectList failed.\n");
+                        exit(1);
+                    }
+                    for (int k = 0; k < res->accepted_count; k++) {
+                        is_accepted[res->accepted_idx[k]] = true;
+                    }
+                    for (int k = 0; k < pending_count; k++) {
+                        if (!is_accepted[k] && !BOOKING_AT(&allBookings, cancelled, k)) {
+                            res->rejected_idx[res->rejected_count++] = k;
+                        }
+                    }
+                    free(is_accepted);
 
-                char ack[12];
-                read(ctop_fd[1][0], ack, sizeof(ack));
-                if (strcmp(ack, "ACK_COUNTER") != 0) {
-                    break;
+                    if (send_message(ptoc_fd[CHILD_OUTPUT][1], MSG_REPORT, &req, res->accepted_idx, res->accepted_count)) {
+                        output_replies++;
+                    }
+                    if (analyze && send_message(ptoc_fd[CHILD_ANALYZER][1], MSG_ANALYZE, &req, res->accepted_idx, res->accepted_count)) {
+                        analyzer_replies++;
+                    }
                 }
+            }
 
-                write(ptoc_fd[1][1], pending_bookings, pending_count * sizeof(Booking)); // Send pending bookings
-
-                char final_ack[9];
-                read(ctop_fd[1][0], final_ack, sizeof(final_ack));
-                if (strcmp(final_ack, "ACK_LIST") != 0) {
-                    break;
-                }
+            // Append the rendered sections, the summaries go after all the booking lists
+            bool done = true;
+            while (output_replies-- > 0) done = recv_done(ctop_fd[CHILD_OUTPUT][0], &output_ns) && done;
+            while (analyzer_replies-- > 0) done = recv_done(ctop_fd[CHILD_ANALYZER][0], &analyzer_ns) && done;
+            done = send_message(ptoc_fd[CHILD_OUTPUT][1], MSG_FLUSH, NULL, NULL, 0) &&
+                   recv_done(ctop_fd[CHILD_OUTPUT][0], &output_ns) && done;
+            if (analyze) {
+                done = send_message(ptoc_fd[CHILD_ANALYZER][1], MSG_FLUSH, NULL, NULL, 0) &&
+                       recv_done(ctop_fd[CHILD_ANALYZER][0], &analyzer_ns) && done;
+            }
+            if (!done) {
+                fprintf(stderr, "Parent: Report modules did not finish the report.\n");
+            }
+        
+            printf("-> [Done]");
 
-                write(ptoc_fd[1][1], &acceptCounter, sizeof(int)); // Send accepted count
+            // Output and Analyzer work in parallel; the rest of the wall time is spent in
+            // the pipes and in the parent
+            long long total_ns = monotonic_ns() - started;
+            record_stage(&stage_stats[STAGE_PRINT_COMMAND], total_ns);
+            long long report_ns = output_ns > analyzer_ns ? output_ns : analyzer_ns;
+            long long other_ns = total_ns - scheduler_ns - report_ns;
+            record_stage(&stage_stats[STAGE_PRINT_SCHEDULING], scheduler_ns);
+            record_stage(&stage_stats[STAGE_PRINT_REPORT], report_ns);
+            record_stage(&stage_stats[STAGE_PRINT_OTHER], other_ns > 0 ? other_ns : 0);
+            break;
+        }
 
-                char ack_1[12];
-                read(ctop_fd[1][0], ack_1, sizeof(ack));
-                if (strcmp(ack_1, "ACK_COUNTER") != 0) {
-                    break;
+        case CMD_ADD_BATCH:
+            if (next_token(&cur, end, &argument)) {
+                if (argument.ptr[0] == '-') {
+                    argument.ptr++;
+                    argument.len--;
                 }
 
-                write(ptoc_fd[1][1], res->accepted_idx, acceptCounter * sizeof(int)); // Send accepted list
-                
-                char finall_ack[9];
-                read(ctop_fd[1][0], finall_ack, sizeof(finall_ack));
-                if (strcmp(finall_ack, "ACK_INDX") != 0) {
-                    break;
-                }
+                char filename[sizeof(input)];
+                memcpy(filename, argument.ptr, argument.len);
+                filename[argument.len] = '\0';
+                process_batch_file(filename);
             }
+            break;
 
-            if(strcmp(algorithm, "ALL") == 0){
-                for (int a = 0; a < numAlgorithms; a++){
-                    SchedulerResults* res = results[a];
-
-                    // Send algorithm name to Analyzer Module
-                    write(ptoc_fd[2][1], algorithms[a], 6); // Send algorithm name
-                    char ack_algo[9] = {0};
-                    read(ctop_fd[2][0], ack_algo, sizeof(ack_algo)); // Wait for acknowledgment
-                    if (strcmp(ack_algo, "ACK_ALGO") != 0) {
-                        fprintf(stderr, "Parent: Missing ACK_ALGO from Analyzer Module.\n");
-                        break;
-                    }
-
-                    // Communicate with Analyzer Module (child process 2)
-                    write(ptoc_fd[2][1], &pending_count, sizeof(int)); // Send pending count to Analyzer
-                    char ack[12] = {0};
-                    read(ctop_fd[2][0], ack, sizeof(ack)); // Wait for acknowledgment
-                    if (strcmp(ack, "ACK_COUNTER") != 0) {
-                        fprintf(stderr, "Parent: Missing ACK_COUNTER from Analyzer Module.\n");
-                        break;
-                    }
-
-                    // Send pending bookings
-                    write(ptoc_fd[2][1], pending_bookings, pending_count * sizeof(Booking)); // Send pending bookings
-                    char final_ack[9] = {0};
-                    read(ctop_fd[2][0], final_ack, sizeof(final_ack)); // Wait for acknowledgment
-                    if (strcmp(final_ack, "ACK_LIST") != 0) {
-                        fprintf(stderr, "Parent: Missing ACK_LIST from Analyzer Module.\n");
-                        break;
-                    }
-
-                    // Send accepted count
-                    write(ptoc_fd[2][1], &acceptCounter, sizeof(int)); // Send accepted count
-                    char ack_1[12] = {0};
-                    read(ctop_fd[2][0], ack_1, sizeof(ack_1)); // Wait for acknowledgment
-                    if (strcmp(ack_1, "ACK_COUNTER") != 0) {
-                        fprintf(stderr, "Parent: Missing ACK_COUNTER from Analyzer Module.\n");
-                        break;
-                    }
+        case CMD_PRINT_MEMORY:
+            print_memory_usage(&allBookings);
+            break;
 
-                    // Send accepted indices
-                    write(ptoc_fd[2][1], res->accepted_idx, acceptCounter * sizeof(int)); // Send accepted indices
-                    char finall_ack[9] = {0};
-                    read(ctop_fd[2][0], finall_ack, sizeof(finall_ack)); // Wait for acknowledgment
-                    if (strcmp(finall_ack, "ACK_INDX") != 0) {
-                        fprintf(stderr, "Parent: Missing ACK_INDX from Analyzer Module.\n");
-                        break;
-                    }
+        case CMD_CANCEL_BOOKING:
+        case CMD_MODIFY_BOOKING: {
+            BookingUpdate update;
+            // A failed change leaves the bookings as they were, it is no invalid booking request
+            if (change_booking(command->command, cur, end, &update) < 0) break;
+            // The Scheduler workers move the booking in their kept schedules
+            for (int a = 0; a < ALGORITHM_COUNT; a++) {
+                send_message(ptoc_fd[a][1], MSG_UPDATE, NULL, (const int*)&update, sizeof(update) / sizeof(int));
+            }
+            break;
+        }
 
-                    // Send invalid command counter
-                    write(ptoc_fd[2][1], &invalid_command_count, sizeof(int)); // Send invalid command count
-                    char ack_invalid[12] = {0};
-                    read(ctop_fd[2][0], ack_invalid, sizeof(ack_invalid)); // Wait for acknowledgment
-                    if (strcmp(ack_invalid, "ACK_INVALID") != 0) {
-                        fprintf(stderr, "Parent: Missing ACK_INVALID from Analyzer Module.\n");
-                        break;
-                    }          
+        case CMD_STATS: {
+            // Counters of this process plus those each child sends back
+            static StageStats totals[STAGE_COUNT];
+            memcpy(totals, stage_stats, sizeof(totals));
+            for (int c = 0; c < CHILD_COUNT; c++) {
+                ModuleRequest reply;
+                int type, count;
+                int* payload;
+                if (!send_message(ptoc_fd[c][1], MSG_STATS, NULL, NULL, 0) ||
+                    !recv_message(ctop_fd[c][0], &type, &reply, &payload, &count)) {
+                    fprintf(stderr, "Parent: No statistics from child %d.\n", c);
+                    continue;
+                }
+                if (type == MSG_STATS && count * sizeof(int) == sizeof(totals)) {
+                    const StageStats* child = (const StageStats*)payload;
+                    for (int k = 0; k < STAGE_COUNT; k++) merge_stage(&totals[k], &child[k]);
                 }
+                free(payload);
             }
-            
-            free(pending_bookings);
-            printf("-> [Done]");
+            print_stage_stats(totals);
+            break;
         }
 
-        else if (strcmp(token, "addBatch") == 0) {
-            char filename[MAX_STRING_LENGTH];
-            token = strtok(NULL, " ");
-            if (token) {
-                if (token[0] == '-') {
-                    token++;
-                }
-                strcpy(filename, token);
-                filename[strcspn(filename, ";")] = '\0';
-                process_batch_file(filename);
+        case CMD_SET_FORMAT: {
+            // setFormat -text|-csv|-jsonl|-binary;
+            int format = FORMAT_COUNT;
+            if (next_token(&cur, end, &argument) && argument.len > 1 && argument.ptr[0] == '-' &&
+                ends_command(input, end)) {
+                StrView name = {argument.ptr + 1, argument.len - 1};
+                for (format = 0; format < FORMAT_COUNT && !view_equals(name, format_names[format]); format++);
+            }
+            if (format == FORMAT_COUNT) {
+                printf("Error: Format must be -text, -csv, -jsonl or -binary\n");
+                invalid_command_count++;
+                break;
             }
+            report_format = format;
+            printf("-> [Format %s]", format_names[format]);
+            break;
         }
 
-        else{
-            printf("Unknown command: %s\n", token);
+        default:
+            printf("Unknown command: %.*s\n", keyword.len, keyword.ptr);
+            break;
         }
-       
     }
+    close_store(); // input ended without endProgram
     return 0;
 }
 
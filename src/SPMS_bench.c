@@ -0,0 +1,909 @@
+// SPMS workload generator, end-to-end benchmark and checks
+//
+// Build: gcc -O2 -o SPMS_bench src/SPMS_bench.c
+//
+// Generate a batch file (and the members file it refers to):
+//   ./SPMS_bench gen <batch file> [options]
+// Run SPMS on generated workloads of each size and report the timings:
+//   ./SPMS_bench run [--spms ./SPMS] [--sizes 1000,100000,10000000] [options]
+// Run scripted sessions and check the output and the report (exit status 1 on a failure):
+//   ./SPMS_bench check [--spms ./SPMS] [--dir PATH]
+//
+// Options:
+//   --bookings N        bookings to generate (gen only, default 1000)
+//   --members N         members in the registry (default 5)
+//   --days N            date span of the bookings (default 30)
+//   --start YYYY-MM-DD  first date (default 2025-05-10)
+//   --seed N            random seed, the same seed gives the same file (default 1)
+//   --types P,R,E,S     weights of addParking, addReservation, addEvent, bookEssentials (default 1,1,1,1)
+//   --essentials W0,W1,W2,W3  weights of 0..3 essentials per booking (default 2,2,1,0)
+//   --members-file PATH members file to write (gen only, default members.txt next to the batch file)
+//   --dir PATH          working directory for the runs (run and check, default a new directory in /tmp)
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <limits.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#define MAX_SIZES 16
+#define TYPE_COUNT 4
+#define ESSENTIAL_COUNT 6
+#define MAX_ESSENTIALS_PER_BOOKING 3
+
+static const char* commands[TYPE_COUNT] = {"addParking", "addReservation", "addEvent", "bookEssentials"};
+static const char* essentials[ESSENTIAL_COUNT] = {"battery", "cable", "locker", "umbrella", "inflationservice", "valetpark"};
+
+typedef struct Workload {
+    long bookings;
+    int members;
+    int days;
+    int start_year, start_month, start_day;
+    unsigned long long seed;
+    int type_weights[TYPE_COUNT];
+    int essential_weights[MAX_ESSENTIALS_PER_BOOKING + 1];
+} Workload;
+
+// splitmix64, so a seed gives the same file on every platform
+static unsigned long long next_random(unsigned long long* state) {
+    unsigned long long z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static int random_below(unsigned long long* state, int bound) {
+    return (int)(next_random(state) % (unsigned long long)bound);
+}
+
+// Index picked with probability proportional to its weight
+static int random_weighted(unsigned long long* state, const int* weights, int count) {
+    int total = 0;
+    for (int i = 0; i < count; i++) total += weights[i];
+    if (total <= 0) return 0;
+    int r = random_below(state, total);
+    for (int i = 0; i < count; i++) {
+        if (r < weights[i]) return i;
+        r -= weights[i];
+    }
+    return count - 1;
+}
+
+// Days since 1970-01-01 of a civil date, and back
+static long days_from_civil(int y, int m, int d) {
+    y -= m <= 2;
+    long era = (y >= 0 ? y : y - 399) / 400;
+    long yoe = y - era * 400;
+    long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+static void civil_from_days(long z, int* y, int* m, int* d) {
+    z += 719468;
+    long era = (z >= 0 ? z : z - 146096) / 146097;
+    long doe = z - era * 146097;
+    long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long mp = (5 * doy + 2) / 153;
+    *d = (int)(doy - (153 * mp + 2) / 5 + 1);
+    *m = (int)(mp < 10 ? mp + 3 : mp - 9);
+    *y = (int)(yoe + era * 400 + (*m <= 2));
+}
+
+static bool write_members(const char* path, int count) {
+    FILE* fp = fopen(path, "w");
+    if (!fp) {
+        perror("Unable to write members file");
+        return false;
+    }
+    for (int i = 0; i < count; i++) fprintf(fp, "member_%d\n", i);
+    fclose(fp);
+    return true;
+}
+
+static bool write_batch(const char* path, const Workload* w) {
+    FILE* fp = fopen(path, "w");
+    if (!fp) {
+        perror("Unable to write batch file");
+        return false;
+    }
+    static char buffer[1 << 20];
+    setvbuf(fp, buffer, _IOFBF, sizeof(buffer));
+
+    unsigned long long state = w->seed;
+    long first_day = days_from_civil(w->start_year, w->start_month, w->start_day);
+    for (long i = 0; i < w->bookings; i++) {
+        int type = random_weighted(&state, w->type_weights, TYPE_COUNT);
+        int year, month, day;
+        civil_from_days(first_day + random_below(&state, w->days), &year, &month, &day);
+        int hour = random_below(&state, 24), minute = random_below(&state, 4) * 15;
+        int half_hours = 1 + random_below(&state, 8); // 0.5 to 4 hours
+
+        fprintf(fp, "%s -member_%d %04d-%02d-%02d %02d:%02d %.1f", commands[type],
+                random_below(&state, w->members), year, month, day, hour, minute, half_hours / 2.0);
+
+        // bookEssentials needs at least one essential
+        int count = random_weighted(&state, w->essential_weights, MAX_ESSENTIALS_PER_BOOKING + 1);
+        if (type == 3 && count == 0) count = 1;
+        unsigned int picked = 0;
+        while (count > 0) {
+            int e = random_below(&state, ESSENTIAL_COUNT);
+            if (picked & (1u << e)) continue;
+            picked |= 1u << e;
+            fprintf(fp, " %s", essentials[e]);
+            count--;
+        }
+        fputs(";\n", fp);
+    }
+    fclose(fp);
+    return true;
+}
+
+static bool parse_weights(const char* text, int* weights, int count) {
+    for (int i = 0; i < count; i++) {
+        char* end;
+        long value = strtol(text, &end, 10);
+        if (end == text || value < 0) return false;
+        weights[i] = (int)value;
+        if (i < count - 1) {
+            if (*end != ',') return false;
+            text = end + 1;
+        } else if (*end) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static long long monotonic_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// Rows of the stats command read after printBookings
+enum {
+    PRINT_SCHEDULING,
+    PRINT_REPORT,
+    PRINT_OTHER,
+    PRINT_STAGES
+};
+
+// Reads the output of SPMS up to its next prompt. Only the first part of each
+// line is kept; the "-> [Pending]" acknowledgements of a batch form one huge line.
+typedef struct Session {
+    pid_t pid;
+    FILE* in;
+    int out;
+    char line[256];
+    size_t line_length;
+    char batch_line[256];
+    double print_seconds[PRINT_STAGES];     // Total s of the print_stages rows of the stats command
+} Session;
+
+// Rows of the stats command splitting up the printBookings time
+static const char* print_stages[PRINT_STAGES] = {"print scheduling", "print report", "print IPC/other"};
+
+static void end_line(Session* s) {
+    s->line[s->line_length < sizeof(s->line) - 1 ? s->line_length : sizeof(s->line) - 1] = '\0';
+    if (strncmp(s->line, "Batch:", 6) == 0) strcpy(s->batch_line, s->line);
+    for (int k = 0; k < PRINT_STAGES; k++) {
+        // "<stage> <count> <total s> ..."
+        size_t length = strlen(print_stages[k]);
+        if (strncmp(s->line, print_stages[k], length) == 0 && s->line[length] == ' ') {
+            sscanf(s->line + length, "%*d %lf", &s->print_seconds[k]);
+        }
+    }
+    s->line_length = 0;
+}
+
+static bool wait_prompt(Session* s) {
+    static const char prompt[] = "Please enter booking:";
+    char buffer[1 << 16];
+    for (;;) {
+        ssize_t n = read(s->out, buffer, sizeof(buffer));
+        if (n <= 0) return false;
+        for (ssize_t k = 0; k < n; k++) {
+            if (buffer[k] != '\n') {
+                if (s->line_length < sizeof(s->line) - 1) s->line[s->line_length] = buffer[k];
+                s->line_length++;
+                continue;
+            }
+            bool is_prompt = s->line_length == sizeof(prompt) - 1 && memcmp(s->line, prompt, s->line_length) == 0;
+            end_line(s);
+            if (is_prompt) {
+                if (k + 1 < n) fprintf(stderr, "Unexpected output after the prompt\n");
+                return true;
+            }
+        }
+    }
+}
+
+static bool send_command(Session* s, const char* command, double* seconds) {
+    long long started = monotonic_ns();
+    fprintf(s->in, "%s\n", command);
+    fflush(s->in);
+    bool ok = wait_prompt(s);
+    *seconds = (monotonic_ns() - started) / 1e9;
+    return ok;
+}
+
+// Start SPMS in dir, keeping its bookings in the store directory when store is not NULL
+static bool start_spms(Session* s, const char* spms, const char* dir, const char* store) {
+    int to_child[2], from_child[2];
+    if (pipe(to_child) < 0 || pipe(from_child) < 0) {
+        perror("pipe");
+        return false;
+    }
+    s->pid = fork();
+    if (s->pid < 0) {
+        perror("fork");
+        return false;
+    }
+    if (s->pid == 0) {
+        setpgid(0, 0); // a group of its own with its modules, so a kill reaches them all
+        dup2(to_child[0], STDIN_FILENO);
+        dup2(from_child[1], STDOUT_FILENO);
+        close(to_child[0]);
+        close(to_child[1]);
+        close(from_child[0]);
+        close(from_child[1]);
+        if (chdir(dir) < 0) {
+            perror("chdir");
+            _exit(1);
+        }
+        if (store) execl(spms, spms, "-store", store, (char*)NULL);
+        else execl(spms, spms, (char*)NULL);
+        perror("Unable to start SPMS");
+        _exit(1);
+    }
+    close(to_child[0]);
+    close(from_child[1]);
+    s->in = fdopen(to_child[1], "w");
+    s->out = from_child[0];
+    s->line_length = 0;
+    s->batch_line[0] = '\0';
+    for (int k = 0; k < PRINT_STAGES; k++) s->print_seconds[k] = 0;
+    return s->in != NULL;
+}
+
+// One end-to-end run: addBatch, printBookings -ALL, stats (for the split of the printBookings time), endProgram
+static bool run_size(const char* spms, const char* dir, Workload* w) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/members.txt", dir);
+    if (!write_members(path, w->members)) return false;
+    snprintf(path, sizeof(path), "%s/bench.dat", dir);
+    if (!write_batch(path, w)) return false;
+
+    Session s;
+    if (!start_spms(&s, spms, dir, NULL) || !wait_prompt(&s)) return false;
+
+    double batch_seconds, print_seconds, stats_seconds, exit_seconds;
+    bool ok = send_command(&s, "addBatch -bench.dat;", &batch_seconds) &&
+              send_command(&s, "printBookings -ALL;", &print_seconds) &&
+              send_command(&s, "stats;", &stats_seconds);
+    fprintf(s.in, "endProgram;\n");
+    fclose(s.in);
+    long long started = monotonic_ns();
+    char drain[4096];
+    while (read(s.out, drain, sizeof(drain)) > 0);
+    close(s.out);
+    exit_seconds = (monotonic_ns() - started) / 1e9;
+
+    int status;
+    // Usage of this run's SPMS only: its peak RSS is the largest of the SPMS process and
+    // the modules it reaped (RUSAGE_CHILDREN would keep the peak of the earlier sizes)
+    struct rusage usage;
+    wait4(s.pid, &status, 0, &usage);
+    long peak_kb = usage.ru_maxrss;
+    if (!ok || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "SPMS did not complete the run of %ld bookings\n", w->bookings);
+        return false;
+    }
+
+    // "Batch: <lines> line(s) in <s> s (<rate> lines/s)"
+    double ingest_rate = 0;
+    const char* rate = strrchr(s.batch_line, '(');
+    if (rate) ingest_rate = atof(rate + 1);
+
+    printf("%10ld  %12.0f  %9.3f  %10.3f  %8.3f  %8.3f  %9.3f  %6.3f  %9.1f\n", w->bookings, ingest_rate,
+           batch_seconds, s.print_seconds[PRINT_SCHEDULING], s.print_seconds[PRINT_OTHER],
+           s.print_seconds[PRINT_REPORT], print_seconds, exit_seconds, peak_kb / 1024.0);
+    fflush(stdout);
+    return true;
+}
+
+/* Checks */
+// A scripted SPMS session: the commands go to stdin, then verify looks at the console output
+// and the report. Every session starts without a report, with member_0 to member_4 and the
+// given capacity file (none for the defaults of 3 slots and 3 of each essential).
+typedef struct Check {
+    const char* name;
+    const char* capacity;
+    const char* commands;
+    long bookings;          // generated into check.dat when not 0
+    bool (*verify)(const char* output, const char* report);
+} Check;
+
+static char* read_file(const char* path) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) return NULL;
+    size_t length = 0, capacity = 4096;
+    char* text = malloc(capacity);
+    size_t n;
+    while (text && (n = fread(text + length, 1, capacity - length - 1, fp)) > 0) {
+        length += n;
+        if (capacity - length <= 1) {
+            char* grown = realloc(text, capacity *= 2);
+            if (!grown) free(text);
+            text = grown;
+        }
+    }
+    fclose(fp);
+    if (text) text[length] = '\0';
+    return text;
+}
+
+static bool write_text(const char* path, const char* text) {
+    FILE* fp = fopen(path, "w");
+    if (!fp) {
+        perror(path);
+        return false;
+    }
+    fputs(text, fp);
+    fclose(fp);
+    return true;
+}
+
+// Run SPMS in dir with the commands on stdin (on the store directory when store is not NULL),
+// collecting its console output, errors included, and report
+static bool run_session(const char* spms, const char* dir, const Check* check, const char* store, char** output,
+                        char** report) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/capacity.txt", dir);
+    if (check->capacity ? !write_text(path, check->capacity) : unlink(path) < 0 && errno != ENOENT) return false;
+    snprintf(path, sizeof(path), "%s/SPMS_Report_G34.txt", dir);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/members.txt", dir);
+    if (!write_members(path, 5)) return false;
+    snprintf(path, sizeof(path), "%s/check.txt", dir);
+    if (!write_text(path, check->commands)) return false;
+    if (check->bookings) {
+        // Many essentials per booking over few days, so their capacities are contended
+        Workload w = {check->bookings, 5, 3, 2025, 5, 10, 7, {1, 1, 1, 1}, {0, 2, 2, 1}};
+        snprintf(path, sizeof(path), "%s/check.dat", dir);
+        if (!write_batch(path, &w)) return false;
+    }
+
+    fflush(stdout); // or the child's freopen writes the pending output again
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return false;
+    }
+    if (pid == 0) {
+        if (chdir(dir) < 0 || !freopen("check.txt", "r", stdin) || !freopen("check.out", "w", stdout) ||
+            dup2(STDOUT_FILENO, STDERR_FILENO) < 0) {
+            perror("Unable to set up the session");
+            _exit(1);
+        }
+        if (store) execl(spms, spms, "-store", store, (char*)NULL);
+        else execl(spms, spms, (char*)NULL);
+        perror("Unable to start SPMS");
+        _exit(1);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) return false;
+
+    snprintf(path, sizeof(path), "%s/check.out", dir);
+    *output = read_file(path);
+    snprintf(path, sizeof(path), "%s/SPMS_Report_G34.txt", dir);
+    *report = read_file(path);
+    return *output && *report;
+}
+
+// Every "<resource> - <peak>/<capacity>" line of the Peak Concurrent Occupancy sections
+// has peak <= capacity; returns the number of lines checked (-1 on a violation)
+static int check_peaks(const char* report) {
+    static const char heading[] = "Peak Concurrent Occupancy:\n";
+    int lines = 0;
+    for (const char* p = strstr(report, heading); p; p = strstr(p, heading)) {
+        p += sizeof(heading) - 1;
+        while (*p && *p != '\n') {
+            const char* end = strchr(p, '\n');
+            if (!end) end = p + strlen(p);
+            const char* dash = strstr(p, " - ");
+            int peak, capacity;
+            if (dash && dash < end && sscanf(dash + 3, "%d/%d", &peak, &capacity) == 2) {
+                if (peak > capacity) {
+                    printf("  peak above capacity: %.*s\n", (int)(end - p), p);
+                    return -1;
+                }
+                lines++;
+            }
+            p = *end ? end + 1 : end;
+        }
+    }
+    return lines;
+}
+
+static bool expect_peaks(const char* report, int sections) {
+    int lines = check_peaks(report);
+    if (lines < 0) return false;
+    // the parking slots and the six essentials in each summary
+    if (lines == sections * 7) return true;
+    printf("  %d peak occupancy lines, expected %d\n", lines, sections * 7);
+    return false;
+}
+
+// "Number of Bookings Assigned" of an algorithm's summary (-1 if it has none)
+static int assigned_count(const char* report, const char* algorithm) {
+    char heading[32];
+    snprintf(heading, sizeof(heading), "For %s:\n", algorithm);
+    const char* summary = strstr(report, heading);
+    const char* field = summary ? strstr(summary, "Number of Bookings Assigned: ") : NULL;
+    return field ? atoi(field + strlen("Number of Bookings Assigned: ")) : -1;
+}
+
+static bool expect_assigned(const char* report, const char* algorithm, int expected) {
+    int assigned = assigned_count(report, algorithm);
+    if (assigned == expected) return true;
+    printf("  %s assigned %d bookings, expected %d\n", algorithm, assigned, expected);
+    return false;
+}
+
+// Two battery and two cable bookings at once: each takes its pair, so the fourth would
+// need a fourth battery and cable and must be rejected
+static bool verify_pairs(const char* output, const char* report) {
+    (void)output;
+    bool ok = true;
+    ok = expect_assigned(report, "fcfs", 3) && ok;
+    ok = expect_assigned(report, "prio", 3) && ok;
+    ok = expect_peaks(report, 3) && ok;
+    return ok;
+}
+
+// With one of each essential, a booking and one taking its pair never both fit. Opti would
+// accept all six for the most booked time if it left the pairs out.
+static bool verify_opti_pairs(const char* output, const char* report) {
+    (void)output;
+    bool ok = true;
+    ok = expect_assigned(report, "opti", 3) && ok;
+    ok = expect_peaks(report, 3) && ok;
+    return ok;
+}
+
+// A generated workload that contends for the essentials stays within every capacity
+static bool verify_peaks(const char* output, const char* report) {
+    (void)output;
+    return expect_peaks(report, 3);
+}
+
+static int count_text(const char* text, const char* pattern) {
+    int count = 0;
+    for (const char* p = text; (p = strstr(p, pattern)); p += strlen(pattern)) count++;
+    return count;
+}
+
+static bool expect_count(const char* text, const char* pattern, int expected) {
+    int count = count_text(text, pattern);
+    if (count == expected) return true;
+    printf("  \"%s\" appears %d times, expected %d\n", pattern, count, expected);
+    return false;
+}
+
+// Both ends of the accepted years are stored and printed as given, the years
+// just outside and a far one (whose minutes would overflow an int) are rejected
+static bool verify_year_range(const char* output, const char* report) {
+    bool ok = true;
+    ok = expect_count(output, "-> [Pending]", 2) && ok;
+    ok = expect_count(output, "Error: Invalid date/time format", 3) && ok;
+    ok = expect_count(report, "1900-01-01  00:00  01:00  Parking", 1) && ok;
+    ok = expect_count(report, "2999-12-31  23:00  24:00  Parking", 1) && ok;
+    return ok;
+}
+
+// A ';' on its own ends a command like an attached one
+static bool verify_bare_semicolon(const char* output, const char* report) {
+    bool ok = true;
+    ok = expect_count(output, "-> [Pending]", 2) && ok;
+    ok = expect_count(output, "Error", 0) && ok;
+    ok = expect_count(output, "-> Bye!", 1) && ok;
+    ok = expect_assigned(report, "fcfs", 2) && ok;
+    return ok;
+}
+
+// A booking with an unknown essential is stored, then rejected by every scheduler and listed
+// with the others; it is no invalid request
+static bool verify_unknown_essential(const char* output, const char* report) {
+    bool ok = true;
+    ok = expect_count(output, "-> [Pending]", 3) && ok;
+    ok = expect_count(output, "Error", 0) && ok;
+    ok = expect_count(report, "Total Number of Bookings Received: 3", 3) && ok;
+    ok = expect_count(report, "Invalid request(s) made: 0", 3) && ok;
+    ok = expect_count(report, "2025-05-10  12:00  13:00  *              unknown", 3) && ok;
+    ok = expect_assigned(report, "fcfs", 1) && ok;
+    ok = expect_assigned(report, "prio", 1) && ok;
+    ok = expect_assigned(report, "opti", 1) && ok;
+    return ok;
+}
+
+// The report of the last printBookings -ALL, which is appended after those of earlier ones
+static const char* last_print(const char* report) {
+    static const char heading[] = "*** ACCEPTED Bookings - fcfs ***";
+    const char* last = report;
+    for (const char* p = report; (p = strstr(p, heading)); p += sizeof(heading) - 1) last = p;
+    return last;
+}
+
+// Each kept schedule moves the waiting booking into the slot a cancelled one frees
+static bool verify_cancel_promotes(const char* output, const char* report) {
+    const char* last = last_print(report);
+    bool ok = true;
+    ok = expect_count(output, "-> [Cancelled]", 1) && ok;
+    ok = expect_count(report, "member_3 has the following REJECTED bookings:", 3) && ok;
+    ok = expect_count(last, "member_3 has the following ACCEPTED bookings:", 3) && ok;
+    ok = expect_count(last, "member_1 has the following", 0) && ok;
+    ok = expect_assigned(last, "fcfs", 3) && ok;
+    ok = expect_assigned(last, "prio", 3) && ok;
+    ok = expect_assigned(last, "opti", 3) && ok;
+    return ok;
+}
+
+// A booking moved onto full slots waits instead of overbooking them
+static bool verify_modify_waits(const char* output, const char* report) {
+    const char* last = last_print(report);
+    bool ok = true;
+    ok = expect_count(output, "-> [Modified]", 1) && ok;
+    ok = expect_count(report, "member_3 has the following ACCEPTED bookings:", 3) && ok;
+    ok = expect_count(last, "member_3 has the following REJECTED bookings:", 3) && ok;
+    ok = expect_count(last, "2025-05-10  11:00  13:00  Parking", 3) && ok;
+    ok = expect_assigned(last, "fcfs", 3) && ok;
+    ok = expect_assigned(last, "prio", 3) && ok;
+    ok = expect_assigned(last, "opti", 3) && ok;
+    ok = expect_peaks(last, 3) && ok;
+    return ok;
+}
+
+// Changes sent back to back reach each kept schedule in order; the failed ones change
+// nothing and are not invalid requests
+static bool verify_rapid_updates(const char* output, const char* report) {
+    const char* last = last_print(report);
+    bool ok = true;
+    ok = expect_count(output, "-> [Modified]", 8) && ok;
+    ok = expect_count(output, "Error: No booking of", 2) && ok;
+    ok = expect_count(last, "2025-05-10  18:00  20:00  Parking", 3) && ok;
+    ok = expect_count(last, "2025-05-10  10:00  12:00  Parking", 9) && ok;
+    ok = expect_count(last, "REJECTED bookings:", 0) && ok;
+    ok = expect_count(report, "Invalid request(s) made: 0", 6) && ok;
+    ok = expect_assigned(last, "fcfs", 4) && ok;
+    ok = expect_assigned(last, "prio", 4) && ok;
+    ok = expect_assigned(last, "opti", 4) && ok;
+    return ok;
+}
+
+static const Check checks[] = {
+    {"essential pairs share the capacity", NULL,
+     "bookEssentials -member_0 2025-05-10 10:00 2.0 battery;\n"
+     "bookEssentials -member_1 2025-05-10 10:00 2.0 battery;\n"
+     "bookEssentials -member_2 2025-05-10 10:00 2.0 cable;\n"
+     "bookEssentials -member_3 2025-05-10 11:00 2.0 cable;\n"
+     "printBookings -ALL;\nendProgram;\n",
+     0, verify_pairs},
+    {"opti keeps essential pairs within capacity", "parking 10\nessentials 1\n",
+     "addParking -member_0 2025-05-10 10:00 4.0 battery;\n"
+     "addParking -member_1 2025-05-10 10:00 4.0 cable;\n"
+     "addReservation -member_2 2025-05-10 12:00 1.0 locker;\n"
+     "addReservation -member_3 2025-05-10 12:00 1.0 umbrella;\n"
+     "bookEssentials -member_4 2025-05-10 15:00 2.0 valetpark;\n"
+     "bookEssentials -member_0 2025-05-10 15:00 2.0 inflationservice;\n"
+     "printBookings -ALL;\nendProgram;\n",
+     0, verify_opti_pairs},
+    {"booking years 1900 to 2999", NULL,
+     "addParking -member_0 1900-01-01 00:00 1.0;\n"
+     "addParking -member_0 2999-12-31 23:00 1.0;\n"
+     "addParking -member_0 1899-12-31 23:00 1.0;\n"
+     "addParking -member_0 3000-01-01 00:00 1.0;\n"
+     "addParking -member_0 9999-12-31 10:00 1.0;\n"
+     "printBookings -fcfs;\nendProgram;\n",
+     0, verify_year_range},
+    {"bare semicolon ends a command", NULL,
+     "addParking -member_0 2025-05-10 10:00 2.0 battery ;\n"
+     "addReservation -member_1 2025-05-10 12:00 1.0 ;\n"
+     "printBookings -ALL ;\nendProgram ;\n",
+     0, verify_bare_semicolon},
+    {"unknown essential is rejected", NULL,
+     "addParking -member_0 2025-05-10 10:00 2.0 battery;\n"
+     "addParking -member_1 2025-05-10 10:00 2.0 flux battery;\n"
+     "bookEssentials -member_2 2025-05-10 12:00 1.0 flux;\n"
+     "printBookings -ALL;\nendProgram;\n",
+     0, verify_unknown_essential},
+    {"cancel promotes a waiting booking", NULL,
+     "addParking -member_0 2025-05-10 10:00 2.0;\n"
+     "addParking -member_1 2025-05-10 10:00 2.0;\n"
+     "addParking -member_2 2025-05-10 10:00 2.0;\n"
+     "addParking -member_3 2025-05-10 10:00 2.0;\n"
+     "printBookings -ALL;\n"
+     "cancelBooking -member_1 2025-05-10 10:00;\n"
+     "printBookings -ALL;\nendProgram;\n",
+     0, verify_cancel_promotes},
+    {"modify onto full slots waits", NULL,
+     "addParking -member_0 2025-05-10 10:00 2.0;\n"
+     "addParking -member_1 2025-05-10 10:00 2.0;\n"
+     "addParking -member_2 2025-05-10 10:00 2.0;\n"
+     "addParking -member_3 2025-05-10 13:00 2.0;\n"
+     "printBookings -ALL;\n"
+     "modifyBooking -member_3 2025-05-10 13:00 2025-05-10 11:00 2.0;\n"
+     "printBookings -ALL;\nendProgram;\n",
+     0, verify_modify_waits},
+    {"rapid updates", NULL,
+     "addParking -member_0 2025-05-10 10:00 2.0;\n"
+     "addParking -member_1 2025-05-10 10:00 2.0;\n"
+     "addParking -member_2 2025-05-10 10:00 2.0;\n"
+     "addParking -member_3 2025-05-10 10:00 2.0;\n"
+     "printBookings -ALL;\n"
+     "modifyBooking -member_0 2025-05-10 10:00 2025-05-10 11:00 2.0;\n"
+     "modifyBooking -member_0 2025-05-10 11:00 2025-05-10 12:00 2.0;\n"
+     "modifyBooking -member_0 2025-05-10 10:00 2025-05-10 12:00 2.0;\n"
+     "modifyBooking -member_0 2025-05-10 12:00 2025-05-10 13:00 2.0;\n"
+     "modifyBooking -member_0 2025-05-10 13:00 2025-05-10 14:00 2.0;\n"
+     "modifyBooking -member_0 2025-05-10 14:00 2025-05-10 15:00 2.0;\n"
+     "modifyBooking -member_0 2025-05-10 15:00 2025-05-10 16:00 2.0;\n"
+     "cancelBooking -member_4 2025-05-10 10:00;\n"
+     "modifyBooking -member_0 2025-05-10 16:00 2025-05-10 17:00 2.0;\n"
+     "modifyBooking -member_0 2025-05-10 17:00 2025-05-10 18:00 2.0;\n"
+     "printBookings -ALL;\nendProgram;\n",
+     0, verify_rapid_updates},
+    {"peak occupancy within capacity", "parking 4\nessentials 2\n",
+     "addBatch -check.dat;\nprintBookings -ALL;\nendProgram;\n",
+     2000, verify_peaks},
+};
+
+/* Store checks */
+// SPMS with -store keeps its bookings in the store directory: a killed session leaves them in
+// the journal, a session ending with endProgram folds them into the snapshot. Each check's
+// session starts on the store the one before left.
+#define CHECK_STORE "store"
+
+typedef struct StoreCheck {
+    const char* name;
+    bool (*prepare)(const char* spms, const char* dir);    // NULL -> the store as it was left
+    const char* commands;
+    bool (*verify)(const char* output, const char* report);
+} StoreCheck;
+
+static const char store_commands[] =
+    "addParking -member_0 2025-05-10 10:00 2.0;\n"
+    "addParking -member_1 2025-05-10 10:00 2.0;\n"
+    "addParking -member_2 2025-05-10 10:00 2.0;\n"
+    "addParking -member_3 2025-05-10 10:00 2.0;\n"
+    "cancelBooking -member_1 2025-05-10 10:00;\n"
+    "modifyBooking -member_2 2025-05-10 10:00 2025-05-10 14:00 1.0;\n";
+
+// A fresh store holding store_commands, left by a session killed after their last prompt
+// (each command is synced to the journal before the prompt that follows it)
+static bool kill_after_bookings(const char* spms, const char* dir) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s/SPMS_G34.wal", dir, CHECK_STORE);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/%s/SPMS_G34.snap", dir, CHECK_STORE);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/members.txt", dir);
+    if (!write_members(path, 5)) return false;
+
+    Session s;
+    if (!start_spms(&s, spms, dir, CHECK_STORE) || !wait_prompt(&s)) return false;
+    bool ok = true;
+    for (const char* line = store_commands; *line && ok; line = strchr(line, '\n') + 1) {
+        fprintf(s.in, "%.*s", (int)(strchr(line, '\n') - line + 1), line);
+        fflush(s.in);
+        ok = wait_prompt(&s);
+    }
+    kill(-s.pid, SIGKILL);
+    waitpid(s.pid, NULL, 0);
+    fclose(s.in);
+    close(s.out);
+    return ok;
+}
+
+// Damage the snapshot's member count: with one member of five the chunks would be read from
+// the wrong place, with their member ids past the registry
+static bool damage_snapshot(const char* spms, const char* dir) {
+    (void)spms;
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s/SPMS_G34.snap", dir, CHECK_STORE);
+    FILE* fp = fopen(path, "r+b");
+    if (!fp) {
+        perror(path);
+        return false;
+    }
+    int member_count = 1;
+    // magic[8], chunk_bytes, booking_count, member_count
+    bool ok = fseek(fp, 16, SEEK_SET) == 0 && fwrite(&member_count, sizeof(int), 1, fp) == 1;
+    fclose(fp);
+    return ok;
+}
+
+// The stored bookings with their cancel and modify: member_3 takes the slot member_1 left
+static bool expect_stored_bookings(const char* report) {
+    bool ok = true;
+    ok = expect_assigned(report, "fcfs", 3) && ok;
+    ok = expect_count(report, "member_1 has the following", 0) && ok;
+    ok = expect_count(report, "member_3 has the following ACCEPTED bookings:", 3) && ok;
+    ok = expect_count(report, "2025-05-10  14:00  15:00  Parking", 3) && ok;
+    return ok;
+}
+
+static bool verify_journal_replay(const char* output, const char* report) {
+    bool ok = expect_count(output, "Restored 4 booking(s) (0 from snapshot, 4 from journal)", 1);
+    return expect_stored_bookings(report) && ok;
+}
+
+static bool verify_snapshot_restore(const char* output, const char* report) {
+    bool ok = expect_count(output, "Restored 4 booking(s) (4 from snapshot, 0 from journal)", 1);
+    return expect_stored_bookings(report) && ok;
+}
+
+// A damaged snapshot is reported and left out; the session goes on with an empty store
+static bool verify_damaged_snapshot(const char* output, const char* report) {
+    bool ok = true;
+    ok = expect_count(output, "is damaged and was not loaded", 1) && ok;
+    ok = expect_count(output, "Restored", 0) && ok;
+    ok = expect_assigned(report, "fcfs", 1) && ok;
+    return ok;
+}
+
+static const StoreCheck store_checks[] = {
+    {"store replays the journal after a kill", kill_after_bookings,
+     "printBookings -ALL;\nendProgram;\n", verify_journal_replay},
+    {"store restores the snapshot", NULL,
+     "printBookings -ALL;\nendProgram;\n", verify_snapshot_restore},
+    {"store rejects a damaged snapshot", damage_snapshot,
+     "addParking -member_4 2025-05-11 10:00 1.0;\nprintBookings -ALL;\nendProgram;\n", verify_damaged_snapshot},
+};
+
+static int run_store_checks(const char* spms, const char* dir) {
+    int failed = 0;
+    for (size_t c = 0; c < sizeof(store_checks) / sizeof(store_checks[0]); c++) {
+        const StoreCheck* check = &store_checks[c];
+        Check session = {check->name, NULL, check->commands, 0, check->verify};
+        char* output = NULL;
+        char* report = NULL;
+        bool ok = !check->prepare || check->prepare(spms, dir);
+        if (!ok) printf("  unable to prepare the store\n");
+        else if (!(ok = run_session(spms, dir, &session, CHECK_STORE, &output, &report))) {
+            printf("  SPMS did not complete the session\n");
+        }
+        else ok = check->verify(output, report);
+        printf("%s %s\n", ok ? "ok  " : "FAIL", check->name);
+        if (!ok) failed++;
+        free(output);
+        free(report);
+    }
+    return failed;
+}
+
+static int run_checks(const char* spms, const char* dir) {
+    int failed = 0;
+    for (size_t c = 0; c < sizeof(checks) / sizeof(checks[0]); c++) {
+        char* output = NULL;
+        char* report = NULL;
+        bool ok = run_session(spms, dir, &checks[c], NULL, &output, &report);
+        if (!ok) printf("  SPMS did not complete the session\n");
+        else ok = checks[c].verify(output, report);
+        printf("%s %s\n", ok ? "ok  " : "FAIL", checks[c].name);
+        if (!ok) failed++;
+        free(output);
+        free(report);
+    }
+    failed += run_store_checks(spms, dir);
+    printf("%d of %zu checks failed\n", failed,
+           sizeof(checks) / sizeof(checks[0]) + sizeof(store_checks) / sizeof(store_checks[0]));
+    return failed ? 1 : 0;
+}
+
+static void usage(void) {
+    fprintf(stderr, "Usage: SPMS_bench gen <batch file> [options]\n"
+                    "       SPMS_bench run [--spms PATH] [--sizes N,N,...] [options]\n"
+                    "       SPMS_bench check [--spms PATH] [--dir PATH]\n"
+                    "See the comment at the top of SPMS_bench.c for the options.\n");
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || (strcmp(argv[1], "gen") != 0 && strcmp(argv[1], "run") != 0 && strcmp(argv[1], "check") != 0)) {
+        usage();
+        return 1;
+    }
+    bool generate = strcmp(argv[1], "gen") == 0;
+    bool check = strcmp(argv[1], "check") == 0;
+    const char* batch_path = NULL;
+    const char* members_path = NULL;
+    const char* spms = "./SPMS";
+    const char* dir = NULL;
+    long sizes[MAX_SIZES] = {1000, 100000, 10000000};
+    int size_count = 3;
+    Workload w = {1000, 5, 30, 2025, 5, 10, 1, {1, 1, 1, 1}, {2, 2, 1, 0}};
+
+    int a = 2;
+    if (generate) {
+        if (argc < 3) {
+            usage();
+            return 1;
+        }
+        batch_path = argv[a++];
+    }
+    for (; a < argc; a++) {
+        const char* value = a + 1 < argc ? argv[a + 1] : NULL;
+        bool ok = value != NULL;
+        if (ok && strcmp(argv[a], "--bookings") == 0) ok = (w.bookings = atol(value)) >= 0;
+        else if (ok && strcmp(argv[a], "--members") == 0) ok = (w.members = atoi(value)) > 0;
+        else if (ok && strcmp(argv[a], "--days") == 0) ok = (w.days = atoi(value)) > 0;
+        else if (ok && strcmp(argv[a], "--start") == 0) {
+            ok = sscanf(value, "%4d-%2d-%2d", &w.start_year, &w.start_month, &w.start_day) == 3;
+        }
+        else if (ok && strcmp(argv[a], "--seed") == 0) w.seed = strtoull(value, NULL, 10);
+        else if (ok && strcmp(argv[a], "--types") == 0) ok = parse_weights(value, w.type_weights, TYPE_COUNT);
+        else if (ok && strcmp(argv[a], "--essentials") == 0) {
+            ok = parse_weights(value, w.essential_weights, MAX_ESSENTIALS_PER_BOOKING + 1);
+        }
+        else if (ok && strcmp(argv[a], "--members-file") == 0) members_path = value;
+        else if (ok && strcmp(argv[a], "--spms") == 0) spms = value;
+        else if (ok && strcmp(argv[a], "--dir") == 0) dir = value;
+        else if (ok && strcmp(argv[a], "--sizes") == 0) {
+            size_count = 0;
+            for (const char* p = value; *p && size_count < MAX_SIZES; p++) {
+                sizes[size_count++] = strtol(p, (char**)&p, 10);
+                if (*p != ',') break;
+            }
+        }
+        else ok = false;
+        if (!ok) {
+            fprintf(stderr, "Invalid option %s\n", argv[a]);
+            usage();
+            return 1;
+        }
+        a++;
+    }
+
+    if (generate) {
+        char path[PATH_MAX];
+        if (!members_path) {
+            const char* slash = strrchr(batch_path, '/');
+            snprintf(path, sizeof(path), "%.*smembers.txt", slash ? (int)(slash - batch_path + 1) : 0, batch_path);
+            members_path = path;
+        }
+        return write_members(members_path, w.members) && write_batch(batch_path, &w) ? 0 : 1;
+    }
+
+    // SPMS runs in the work directory, where it finds members.txt and writes its reports
+    char spms_path[PATH_MAX], dir_template[] = "/tmp/spms_bench_XXXXXX";
+    if (!realpath(spms, spms_path)) {
+        perror(spms);
+        return 1;
+    }
+    if (!dir && !(dir = mkdtemp(dir_template))) {
+        perror("mkdtemp");
+        return 1;
+    }
+    if (check) {
+        printf("SPMS %s, work directory %s\n", spms_path, dir);
+        return run_checks(spms_path, dir);
+    }
+    printf("SPMS %s, work directory %s, %d members, %d days, seed %llu\n", spms_path, dir, w.members, w.days, w.seed);
+    printf("peak RSS MB: largest process of each run's own SPMS and its modules\n");
+    printf("  bookings  ingest line/s  ingest s  schedule s     ipc s  report s  printAll s  exit s  peak RSS MB\n");
+    for (int k = 0; k < size_count; k++) {
+        w.bookings = sizes[k];
+        if (!run_size(spms_path, dir, &w)) return 1;
+    }
+    return 0;
+}